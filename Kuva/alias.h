@@ -0,0 +1,131 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* alias.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Class AliasTable
+
+	Walker's alias method: after an O(n) set up from n
+	weights, an index i is drawn with probability
+	w[i] / sum(w) in O(1), with one uniform index and
+	one uniform real.
+
+	Example usage:
+
+	AliasTable table;
+	table.init( weights );      // weights >= 0
+	if ( !table.empty() )
+		i = table.draw( rng );  // rng: RandomStream
+*/
+
+#ifndef K_ALIAS
+#define K_ALIAS
+
+#include "rng.h"
+
+#include <vector>
+
+
+class AliasTable
+{
+public:
+
+	AliasTable() {}
+
+	/* Set up the table (Vose's version), empty if the
+	   weights are all zero */
+	void init( const std::vector< double > & w )
+	{
+		unsigned i, s, l, n = (unsigned) w.size();
+		std::vector< unsigned > small, large;
+		double total = 0;
+
+		prob.assign( n, 0 );
+		alias.assign( n, 0 );
+		for ( i=0; i < n; i++ )
+			total += w[ i ];
+		if ( total <= 0 )
+		{
+			prob.clear();
+			alias.clear();
+			return;
+		}
+
+		/* scaled weights: mean 1 */
+		for ( i=0; i < n; i++ )
+		{
+			prob[ i ] = w[ i ] * n / total;
+			if ( prob[ i ] < 1 ) small.push_back( i );
+			else large.push_back( i );
+		}
+
+		/* each small bucket is completed by a large one */
+		while ( !small.empty() && !large.empty() )
+		{
+			s = small.back(); small.pop_back();
+			l = large.back();
+			alias[ s ] = l;
+			prob[ l ] -= 1 - prob[ s ];
+			if ( prob[ l ] < 1 )
+			{
+				large.pop_back();
+				small.push_back( l );
+			}
+		}
+
+		/* left overs are full, up to rounding errors */
+		while ( !large.empty() ) { prob[ large.back() ] = 1; large.pop_back(); }
+		while ( !small.empty() ) { prob[ small.back() ] = 1; small.pop_back(); }
+	}
+
+	bool empty() { return prob.empty(); }
+
+	unsigned size() { return (unsigned) prob.size(); }
+
+	/* Draw an index; the table must not be empty */
+	unsigned draw( RandomStream & rng )
+	{
+		unsigned i = rng.below( (unsigned) prob.size() );
+		return ( rng.uniform() < prob[ i ] ) ? i : alias[ i ];
+	}
+
+private:
+
+	std::vector< double > prob; /* probability to keep bucket i */
+	std::vector< unsigned > alias; /* index drawn otherwise */
+};
+
+#endif
@@ -45,13 +45,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 /************/
 
 
-vector< uint_t > Args::placeInit() {
+Args::place_t Args::placeInit() {
 	/*
 	Initialisation of the texture, to place the patch
 	at a random position, such that the full image 
 	is displayed.
 	*/
-	vector< uint_t > pos;
+	place_t pos;
 	uint_t x, y;
 	if ( k_pin == PI0 ) {
 		x = (int)( ( t_width - p_width ) * ( (float)rand() / RAND_MAX ) );
@@ -60,309 +60,643 @@ vector< uint_t > Args::placeInit() {
 	else { /* top-left corner */
 		x = y = 0;
 	}
-	pos.push_back( x );
-	pos.push_back( y );
+	pos.x = x;
+	pos.y = y;
+	/* nothing to overlap yet, whole patch */
+	pos.k = 0;
+	pos.x0 = 0;
+	pos.x1 = p_width;
+	pos.y0 = 0;
+	pos.y1 = p_height;
 
 	for ( uint_t i=x; i < x+p_width; i++ )
 		for ( uint_t j=y; j < y+p_height; j++ ) {
 
-			(*img_out) (i % t_width, j % t_height, 0) = (*img_in) (i-pos[0], j-pos[1], 0);
-			(*img_out) (i % t_width, j % t_height, 1) = (*img_in) (i-pos[0], j-pos[1], 1);
-			(*img_out) (i % t_width, j % t_height, 2) = (*img_in) (i-pos[0], j-pos[1], 2);
+			(*img_out) (i % t_width, j % t_height, 0) = (*img_in) (i-pos.x, j-pos.y, 0);
+			(*img_out) (i % t_width, j % t_height, 1) = (*img_in) (i-pos.x, j-pos.y, 1);
+			(*img_out) (i % t_width, j % t_height, 2) = (*img_in) (i-pos.x, j-pos.y, 2);
 
-			(*img_msk) ( i, j ) = 255; 
+			(*img_msk) ( i % t_width, j % t_height ) = 255; 
+			occupancy.set( i % t_width, j % t_height, 1 );
+			unfilled.fill( i % t_width, j % t_height );
+			img_src[ ( j % t_height ) * t_width + i % t_width ] = ( j - pos.y ) * p_width + i - pos.x;
 			nb_pixels++; 
 		}
+		costMapDirty( x, y, p_width, p_height );
+		descDirty( x, y, p_width, p_height );
+		validDirty( x, y, p_width, p_height );
+		finished = unfilled.empty();
 
 		return pos;
 }
 
 
-vector< uint_t > Args::placeRandom() {
+void Args::ssdWindow( uint_t x, uint_t y, uint_t px, uint_t py,
+					 uint_t w, uint_t h, unsigned long long * sums ) {
+	/*
+	Masked SSD, on each channel, between the w x h window
+	of the patch at (px,py) and the texture at (x,y).
+	*/
+	sums[0] = sums[1] = sums[2] = 0;
+	ssdRows( x, y, px, py, w, 0, h, sums );
+}
+
+
+void Args::ssdRows( uint_t x, uint_t y, uint_t px, uint_t py,
+				   uint_t w, uint_t j0, uint_t j1, unsigned long long * sums ) {
+	/*
+	Add to sums the masked SSD of rows j0 to j1 (excluded)
+	of the window of ssdWindow().
+	Rows are handed to the SSD kernel, in two parts when
+	they wrap around the texture border.
+	*/
+	uint_t j, c, ty;
+	uint_t n1 = ( x + w <= t_width ) ? w : t_width - x;
+	uint_t n2 = w - n1;
+
+	for ( j=j0, ty=( y + j0 ) % t_height; j < j1; j++, ty=nextY( ty ) ) {
+
+		const uchar_t * m = img_msk->ptr( x, ty );
+
+		for ( c=0; c < 3; c++ ) {
+
+			const uchar_t * a = img_in->ptr( px, py + j, 0, c );
+			const uchar_t * b = img_out->ptr( x, ty, 0, c );
+
+			sums[ c ] += ssdRow( a, b, m, n1 );
+			if ( n2 )
+				sums[ c ] += ssdRow( a + n1, img_out->ptr( 0, ty, 0, c ), img_msk->ptr( 0, ty ), n2 );
+		}
+	}
+}
+
+
+void Args::targetHole( RandomStream & rng, uint_t & x, uint_t & y ) {
+	/*
+	Random position of a patch covering a hole: a whole
+	component of unfilled pixels if it fits in the patch
+	and few pixels remain, else a frontier pixel (unfilled,
+	next to a filled one), so that the patch overlaps.
+	*/
+	uint_t p, w = 1, h = 1;
+
+	if ( unfilled.frontierSize() )
+		p = unfilled.frontier( rng.below( unfilled.frontierSize() ) );
+	else
+		p = unfilled.unfilled( rng.below( unfilled.size() ) );
+	x = p % t_width;
+	y = p / t_width;
+
+	if ( lastHoles() ) {
+		const HoleIndex::component_t & c = unfilled.component( unfilled.componentOf( p ) );
+		if ( ( c.w <= p_width ) && ( c.h <= p_height ) ) {
+			x = c.x;
+			y = c.y;
+			w = c.w;
+			h = c.h;
+		}
+	}
+
+	/* the w x h box anywhere under the patch */
+	x = ( x + t_width - rng.below( p_width - w + 1 ) ) % t_width;
+	y = ( y + t_height - rng.below( p_height - h + 1 ) ) % t_height;
+}
+
+
+Args::place_t Args::placeRandom() {
 	/*
 	Return a position of the top-left corner for
 	a new patch, using random placement.
 	( checks that there is some overlapping )
-	1. find random coordinates
+	1. find random coordinates (covering a hole,
+	until the texture is finished)
 	2. check in im_msk if overlaps enough
 	3. return (x,y) top left coordinate of the patch
-	[0]: X coordinate
-	[1]: Y coordinate
-	[2]: #pixels overlapping
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
 	*/
-	vector< uint_t > pos;
-	uint_t i, j, k=0, ok = 0;
-	uint_t bound = (int) ( p_width * p_height * ratio );
+	place_t pos;
+	uint_t k=0;
 	uint_t x, y;
+	RandomStream rng( candidateSeed(), 0 );
 
-	while ( !ok ) {
+	/* choose random coordinates, among the ones which overlap enough */
+	validOffsets();
+	sampleOffset( rng, x, y );
+	k = occupancy.sum( x, y, p_width, p_height );
 
-		k = 0;
-		/* choose random coordinates */
-		x = (int)( t_width * ( (float)rand() / RAND_MAX ) );
-		y = (int)( t_height * ( (float)rand() / RAND_MAX ) );
-
-		/* test if enough overlaps */
-		for ( i=x; i < x+p_width; i++ )
-			for ( j=y; j < y+p_height; j++ ) {
-				if ( (*img_msk) ( i % t_width, j % t_height ) != 0 )
-					k++;
-			}
-			if ( k >= bound ) {
-				ok = 1;
-			}
-	}  
-	/* set coordinates vector */
-	pos.push_back( x );
-	pos.push_back( y );
-	pos.push_back( k );
+	/* set coordinates */
+	pos.x = x;
+	pos.y = y;
+	pos.k = k;
 	/* add width limits */
-	pos.push_back( 0 );
-	pos.push_back( p_width );
+	pos.x0 = 0;
+	pos.x1 = p_width;
 	/* add height limits */
-	pos.push_back( 0 );
-	pos.push_back( p_height );
+	pos.y0 = 0;
+	pos.y1 = p_height;
 
 	return pos;
 }
 
 
-vector< uint_t > Args::placeEntireMatching() {
+void Args::validOffsets() {
 	/*
-	Return a position of the top-left corner for
-	a new patch, using Entire Matching placement.
-	[0]: X coordinate
-	[1]: Y coordinate
-	[2]: #pixels overlapping
+	Mark in valid_map the offsets where a whole patch overlaps
+	enough (at least ratio of its pixels) and covers a hole (until
+	the texture is finished): O(1) per offset with the overlap
+	table. Only the offsets under the rects filled since the last
+	call (see validDirty) are checked again, unless the texture
+	got finished: the cost then follows the patch, not the texture.
+	*/
+	uint_t x, y, i, j, r, w, h;
+
+	if ( !valid_done || ( valid_end != end() ) ) {
+
+		valid_map.assign( t_width * t_height, 0 );
+		valid_rows.assign( t_height, 0 );
+		valid_count = 0;
+		valid_end = end();
+
+		for ( y=0; y < t_height; y++ )
+			for ( x=0; x < t_width; x++ )
+				validSet( x, y );
+		valid_done = true;
+	}
+	else {
+		for ( r=0; r < valid_dirty.size(); r++ ) {
+
+			const rect_t & rect = valid_dirty[ r ];
+
+			/* the offsets of the patches over the rect */
+			w = rect.w + p_width - 1;
+			h = rect.h + p_height - 1;
+			if ( w > t_width )
+				w = t_width;
+			if ( h > t_height )
+				h = t_height;
+			x = ( rect.x + t_width - ( p_width - 1 ) % t_width ) % t_width;
+			y = ( rect.y + t_height - ( p_height - 1 ) % t_height ) % t_height;
+
+			for ( j=0; j < h; j++ )
+				for ( i=0; i < w; i++ )
+					validSet( ( x + i ) % t_width, ( y + j ) % t_height );
+		}
+	}
+	valid_dirty.clear();
+
+	if ( ( valid_count == 0 ) && !valid_warned ) {
+		nonfatal( "warning: no position overlaps enough (see -ra), placing patches at random." );
+		valid_warned = true;
+	}
+}
+
+
+void Args::validDirty( uint_t x, uint_t y, uint_t w, uint_t h ) {
+	/*
+	Record that the w x h texture rect at (x,y) got filled,
+	for the next validOffsets(): all offsets are checked again
+	instead once the rects cover more of them than the texture.
+	*/
+	rect_t rect;
+	uint_t r;
+	unsigned long long n = 0;
+
+	/* all offsets will be checked anyway */
+	if ( !valid_done )
+		return;
+
+	rect.x = x % t_width;
+	rect.y = y % t_height;
+	rect.w = w;
+	rect.h = h;
+	valid_dirty.push_back( rect );
+
+	for ( r=0; r < valid_dirty.size(); r++ )
+		n += (unsigned long long) ( valid_dirty[ r ].w + p_width - 1 ) * ( valid_dirty[ r ].h + p_height - 1 );
+	if ( n > (unsigned long long) t_width * t_height ) {
+		valid_done = false;
+		valid_dirty.clear();
+	}
+}
+
+
+void Args::validSet( uint_t x, uint_t y ) {
+	/*
+	Check the offset (x,y) again, and update the counts.
 	*/
-	vector< uint_t > pos;
-	uint_t i, j, k=0, ok=0, tests=0;
 	uint_t fullarea = p_width * p_height;
 	uint_t bound = (uint_t) ( fullarea * ratio );
-	float cost = 100000000, ncost;
-	uint_t sumr=0, sumv=0, sumb=0;
-	uint_t bestx=0, besty=0;
+	uint_t k = occupancy.sum( x, y, p_width, p_height );
+	uint_t o = y * t_width + x;
+	uchar_t v = ( k > 0 ) && ( k >= bound ) && ( ( k < fullarea ) || end() );
+
+	if ( v == valid_map[ o ] )
+		return;
+	valid_map[ o ] = v;
+	if ( v ) {
+		valid_rows[ y ]++;
+		valid_count++;
+	}
+	else {
+		valid_rows[ y ]--;
+		valid_count--;
+	}
+}
+
+
+uint_t Args::validOffset( uint_t i ) {
+	/*
+	i-th valid offset (i < valid_count), in the order of
+	the texture pixels: through the counts per row, then
+	along the row.
+	*/
 	uint_t x, y;
-	bool holes = false;
-
-	while ( tests < PLACE_ENTM_TESTS ) {
-
-		tests++;
-		ok = 0;
-
-		while ( !ok ) {
-
-			/* initialize */
-			k = 0;
-			sumr = sumv = sumb = 0;
-
-			/* choose random coordinates */
-			x = (int)( t_width * ( (float)rand() / RAND_MAX ) );
-			y = (int)( t_height * ( (float)rand() / RAND_MAX ) );    
-			/* test if enough overlaps */
-			for ( i=x; i < x+p_width; i++ )
-				for ( j=y; j < y+p_height; j++ ) {
-					/* if this pixel is already filled, add one more pixel overlapping */
-					if ( (*img_msk) ( i % t_width, j % t_height ) != 0 )
-						k++;
-				}
-				/* k = #pixels overlapped */
-				if ( k >= bound ) {
-					ok = 1;
-				}
-				if ( k == fullarea ) {
-					holes = false;
-				}
-				else {
-					holes = true;
-				}
-		}
-
-		if ( ( end() ) || ( holes ) ) {
-
-			/* one good placement found, computes COST  */
-			for ( i=x; i < x+p_width; i++ )
-				for ( j=y; j < y+p_height; j++ ) {
-					/* here were lays a pixel of the current texture,
-					add its cost to the sum
-					*/
-					if ( (*img_msk) ( i % t_width, j % t_height) != 0 ) {
-
-						int ii = i % t_width, jj = j % t_height;
-						sumr += squares[ abs( (*img_in)(i-x, j-y, 0) - (*img_out)(ii, jj, 0) ) ];
-						sumv += squares[ abs( (*img_in)(i-x, j-y, 1) - (*img_out)(ii, jj, 1) ) ];
-						sumb += squares[ abs( (*img_in)(i-x, j-y, 2) - (*img_out)(ii, jj, 2) ) ];
-					}	    
-				}
-
-				/* compute final cost */
-				sumr = (int)( sumr / k ); 
-				sumv = (int)( sumv / k ); 
-				sumb = (int)( sumb / k );
-
-				/* reduce complexity when empty areas remaining */
-				ncost = ( sumr + sumv + sumb ) / 3;
-				if ( holes ) {
-					ncost = (uint_t) ( ncost * 0.75 );
-				}
-				//    cout << "cost = " << ncost << endl;
-
-				if ( cost > ncost ) {
-					cost = ncost;
-					bestx = x;
-					besty = y;
-				}
+
+	for ( y=0; i >= valid_rows[ y ]; y++ )
+		i -= valid_rows[ y ];
+	for ( x=0; ; x++ )
+		if ( valid_map[ y * t_width + x ] && ( i-- == 0 ) )
+			break;
+	return y * t_width + x;
+}
+
+
+bool Args::sampleOffset( RandomStream & rng, uint_t & x, uint_t & y ) {
+	/*
+	Random offset from validOffsets(): aimed at a hole
+	(see targetHole) for at most PLACE_TRIES draws, then
+	uniformly drawn from the list, so that the time is
+	bounded. If there is no valid offset, false is returned
+	with a random one, on a hole if any is left.
+	*/
+	uint_t t, o;
+
+	if ( valid_count == 0 ) {
+		if ( !end() ) {
+			targetHole( rng, x, y );
 		}
 		else {
-			//tests--;
+			x = rng.below( t_width );
+			y = rng.below( t_height );
+		}
+		return false;
+	}
+
+	if ( !end() ) {
+		for ( t=0; t < PLACE_TRIES; t++ ) {
+			targetHole( rng, x, y );
+			if ( valid_map[ y * t_width + x ] )
+				return true;
 		}
 	}
 
+	o = validOffset( rng.below( valid_count ) );
+	x = o % t_width;
+	y = o / t_width;
+	return true;
+}
+
+
+unsigned long long Args::candidateSeed() {
+	/*
+	Seed of the random streams of a set of candidates,
+	drawn from the main generator.
+	*/
+	unsigned long long seed = 0;
+
+	for ( int i=0; i < 4; i++ )
+		seed = ( seed << 16 ) ^ (unsigned long long) rand();
+	return seed;
+}
+
+
+int Args::bestCandidate( const vector< candidate_t > & cand ) {
+	/*
+	Index of the valid candidate of lowest cost, the first
+	one on ties, -1 if none: the same whatever the number
+	of threads which computed the costs.
+	*/
+	int best = -1;
+
+	for ( int i=0; i < (int) cand.size(); i++ ) {
+		ssd_total += cand[ i ].area;
+		ssd_done += cand[ i ].pixels;
+		if ( cand[ i ].valid && ( best < 0 || cand[ i ].cost < cand[ best ].cost ) )
+			best = i;
+	}
+	return best;
+}
+
+
+float Args::matchCost( const unsigned long long * sums, uint_t k, bool holes ) {
+	/*
+	Cost of a matching placement: mean SSD on the k pixels
+	set, reduced when empty areas remain under the patch.
+	It only grows with the sums, so that the cost of
+	the rows already summed is a lower bound.
+	*/
+	uint_t sumr, sumv, sumb;
+	float ncost;
+
+	sumr = (uint_t)( sums[0] / k ); 
+	sumv = (uint_t)( sums[1] / k ); 
+	sumb = (uint_t)( sums[2] / k );
+
+	ncost = ( sumr + sumv + sumb ) / 3;
+	if ( holes ) {
+		ncost = (uint_t) ( ncost * 0.75 );
+	}
+	return ncost;
+}
+
+
+bool Args::matchScore( candidate_t & c, int i, uint_t px, uint_t py,
+					  uint_t w, uint_t h, bool holes, float & best_cost, int & best_i ) {
+	/*
+	Cost of candidate i, its w x h window of the patch
+	at (px,py) being put at (c.x,c.y). Rows are summed
+	by strips of SSD_STRIP, and the candidate is given up
+	(false returned) as soon as it cannot beat the best
+	candidate so far (best_cost, best_i): its cost is not
+	lower, or equal with a higher index.
+	*/
+	unsigned long long sums[3];
+	uint_t j, j1;
+
+	sums[0] = sums[1] = sums[2] = 0;
+	c.area = w * h;
+	c.pixels = 0;
+
+	for ( j=0; j < h; j = j1 ) {
+
+		j1 = ( j + SSD_STRIP < h ) ? j + SSD_STRIP : h;
+		ssdRows( c.x, c.y, px, py, w, j, j1, sums );
+		c.pixels += ( j1 - j ) * w;
+		c.cost = matchCost( sums, c.k, holes );
+
+		if ( ( best_i >= 0 ) &&
+			( ( c.cost > best_cost ) || ( ( c.cost == best_cost ) && ( i > best_i ) ) ) )
+			return false;
+	}
+
+	best_cost = c.cost;
+	best_i = i;
+	return true;
+}
+
+
+Args::place_t Args::placeEntireMatching() {
+	/*
+	Return a position of the top-left corner for
+	a new patch, using Entire Matching placement.
+	Each candidate offset is drawn from its own random
+	stream, and candidates are scored on nb_jobs threads.
+	Unless prune_ratio is 1, only the candidates closest
+	to the texture by their descriptors get the exact SSD.
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
+	*/
+	place_t pos;
+	vector< candidate_t > & cand = candidates;
+	uint_t fullarea = p_width * p_height;
+	unsigned long long seed = candidateSeed();
+	bool prune = ( prune_ratio < 1 );
+	const vector< int > & kept = desc_kept;
+	int i, best;
+
+	cand.assign( PLACE_ENTM_TESTS, candidate_t() );
+
+	/* offsets which can be drawn, and holes, shared by the threads */
+	validOffsets();
+	if ( lastHoles() )
+		unfilled.components();
+	if ( prune )
+		descriptors();
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads( nb_jobs )
+#endif
+	{
+		/* best candidate scored by this thread, to give up the
+		others early; no shared bound, so that the result does
+		not depend on the threads */
+		float best_cost = 0;
+		int best_i = -1;
+
+#ifdef _OPENMP
+#pragma omp for schedule( dynamic )
+#endif
+		for ( i=0; i < PLACE_ENTM_TESTS; i++ ) {
+
+			RandomStream rng( seed, i );
+			candidate_t & c = cand[ i ];
+			bool holes;
+
+			/* choose random coordinates, which overlap enough:
+			k = #pixels overlapped */
+			c.area = c.pixels = 0;
+			c.valid = sampleOffset( rng, c.x, c.y );
+			if ( !c.valid )
+				continue;
+			c.k = occupancy.sum( c.x, c.y, p_width, p_height );
+			holes = ( c.k != fullarea );
+
+			/* cheap estimate first, when pruning */
+			if ( prune ) {
+				c.cost = descDistance( c.x, c.y );
+				continue;
+			}
+
+			/* one good placement found, computes COST  
+			(on the pixels of the current texture under the patch) */
+			c.valid = matchScore( c, i, 0, 0, p_width, p_height, holes, best_cost, best_i );
+		}
+
+		if ( prune ) {
+
+#ifdef _OPENMP
+#pragma omp single
+#endif
+			descPrune( cand );
+
+			/* closest first, so that the others are given up sooner */
+#ifdef _OPENMP
+#pragma omp for schedule( dynamic )
+#endif
+			for ( i=0; i < (int) kept.size(); i++ ) {
+
+				candidate_t & c = cand[ kept[ i ] ];
+				c.valid = matchScore( c, kept[ i ], 0, 0, p_width, p_height, c.k != fullarea, best_cost, best_i );
+			}
+		}
+	}
+
+	best = bestCandidate( cand );
+	if ( best < 0 )
+		return placeRandom();
+
 	/* add coordinates on output texture */
-	pos.push_back( bestx );
-	pos.push_back( besty );
+	pos.x = cand[ best ].x;
+	pos.y = cand[ best ].y;
 	/* nb of pixels overlapping */
-	pos.push_back( k );
+	pos.k = cand[ best ].k;
 	/* add width limits */
-	pos.push_back( 0 );
-	pos.push_back( p_width );
+	pos.x0 = 0;
+	pos.x1 = p_width;
 	/* add height limits */
-	pos.push_back( 0 );
-	pos.push_back( p_height );
+	pos.y0 = 0;
+	pos.y1 = p_height;
 
 	return pos;
 }
 
 
-vector< uint_t > Args::placeSubMatching() {
+Args::place_t Args::placeSubMatching() {
 	/*
 	Return a position of the top-left corner for
-	a new patch, using Sub Matching placement.
+	a new patch, using Sub Matching placement:
+	only the part of the patch matched, inside the
+	selected area, is given in the limits.
 	*/
 
 	/* 
 	1. Pick a random non-empty area in output image
+	   (until the texture is finished, the window of a
+	   whole patch on a hole, so that the part pasted
+	   covers one)
 	2. Look for the better patch position inside it
 	*/
 
 	uint_t top_leftx, top_lefty, bot_rightx, bot_righty;
 	bool empty = true;
-	uint_t i, j, k=0, bound=0;
+	uint_t k=0, bound=0, tries;
 
 
-	while ( empty ) {
+	for ( tries=0; end() && empty && ( tries < PLACE_TRIES ); tries++ ) {
 
 		/* pick random coordinates in output image */
-		top_leftx = (int)( t_width * ( (float)rand() / RAND_MAX ) );
-		top_lefty = (int)( t_height * ( (float)rand() / RAND_MAX ) );
+		top_leftx = (int)( t_width * ( (float)rand() / RAND_MAX ) ) % t_width;
+		top_lefty = (int)( t_height * ( (float)rand() / RAND_MAX ) ) % t_height;
 		bot_rightx = top_leftx + (int)( (t_width-top_leftx) * ( (float)rand() / RAND_MAX ) );
-		bot_righty = top_lefty + (int)( (t_width-top_leftx) * ( (float)rand() / RAND_MAX ) );
+		bot_righty = top_lefty + (int)( (t_height-top_lefty) * ( (float)rand() / RAND_MAX ) );
+		/* the area is matched against a part of the patch */
+		if ( bot_rightx - top_leftx > p_width )
+			bot_rightx = top_leftx + p_width;
+		if ( bot_righty - top_lefty > p_height )
+			bot_righty = top_lefty + p_height;
 
 		bound = (uint_t) ( (bot_rightx - top_leftx) *  (bot_righty - top_lefty) * 0.1 );
 
-		for ( i=top_leftx; i < bot_rightx; i++ )
-			for ( j=top_lefty; j < bot_righty; j++ ) {
-				/* if non empty area, accept this area*/
-				if ( (*img_msk)(i % t_width, j % t_height) != 0 ) {
-					k++;
-				}
-			}
+		/* if non empty area, accept this area*/
+		k = occupancy.sum( top_leftx, top_lefty, bot_rightx - top_leftx, bot_righty - top_lefty );
 			if ( k > bound )
 				empty = false;
 	}
 
+	if ( empty ) {
+
+		/* no area found, or holes left: the window of a whole patch
+		which overlaps enough, on a hole (see sampleOffset) */
+		RandomStream rng( candidateSeed(), 0 );
+
+		validOffsets();
+		sampleOffset( rng, top_leftx, top_lefty );
+		bot_rightx = top_leftx + p_width;
+		bot_righty = top_lefty + p_height;
+	}
+
 	bound =  (bot_rightx - top_leftx) *  (bot_righty - top_lefty);
 
 	/* Look for best patch position */
 
-	vector< uint_t > pos;
-	uint_t  ok=0, tests=0;
-	float cost = 100000000, ncost;
-	uint_t sumr=0, sumv=0, sumb=0;
-	uint_t bestx=0, besty=0;
-	uint_t x, y;
-
 	/* do not make more tests than possible translations */
-	while ( ( tests < PLACE_SUBM_TESTS ) && ( tests < bound ) ) {
-
-		//    cout << "*\n";
-		tests++;
-		ok = 0;
-		empty = true;
-
-		/* Look for a patch position */
-		while ( !ok ) {
-
-			/* initialize */
-			k = 0;
-			sumr = sumv = sumb = 0;
-
-			/* choose random offset in the selected area of the output image */
-			x = (int)( (bot_rightx-top_leftx) * ( (float)rand() / RAND_MAX ) );
-			y = (int)( (bot_righty-top_lefty) * ( (float)rand() / RAND_MAX ) );
-			//      cout << ": " << x << ", " << y << endl;
-
-			/* test if enough overlaps, between SELECTED AREA (!)  and patch  */
-			for ( i=x+top_leftx; i < bot_rightx; i++ )
-				for ( j=y+top_lefty; j < bot_righty; j++ ) {
-					/* if this pixel is already filled, add one more pixel overlapping */
-					if ( (*img_msk) ( i % t_width, j % t_height ) != 0 ) {
-						k++;
-					}
-				}
-				if ( k )
-					ok = 1;
-		}
-
-		/* one good placement found, computes COST  */
-		for ( i=x+top_leftx; i < bot_rightx; i++ )
-			for ( j=y+top_lefty; j < bot_righty; j++ ) {
-
-				/* here were lays a pixel of the current texture,
-				add its cost to the sum
-				*/
-				if ( (*img_msk) ( i % t_width, j % t_height) != 0 ) {
-
-					int ii = i % t_width, jj = j % t_height;
-					int xx = ( i - top_leftx ) % t_width, yy = ( j - top_lefty ) % t_height;
-
-					sumr += squares[ abs( (*img_in)(xx, yy, 0) - (*img_out)(ii, jj, 0) ) ];
-					sumv += squares[ abs( (*img_in)(xx, yy, 1) - (*img_out)(ii, jj, 1) ) ];
-					sumb += squares[ abs( (*img_in)(xx, yy, 2) - (*img_out)(ii, jj, 2) ) ];
-				}	    
+	int tests = ( bound < PLACE_SUBM_TESTS ) ? (int) bound : PLACE_SUBM_TESTS;
+	place_t pos;
+	vector< candidate_t > & cand = candidates;
+	uint_t w = bot_rightx - top_leftx;
+	uint_t h = bot_righty - top_lefty;
+	unsigned long long seed = candidateSeed();
+	int i, best;
+
+	cand.assign( tests, candidate_t() );
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads( nb_jobs )
+#endif
+	{
+		/* best candidate scored by this thread (see placeEntireMatching) */
+		float best_cost = 0;
+		int best_i = -1;
+
+#ifdef _OPENMP
+#pragma omp for schedule( dynamic )
+#endif
+		for ( i=0; i < tests; i++ ) {
+
+			RandomStream rng( seed, i );
+			candidate_t & c = cand[ i ];
+			uint_t x, y, t;
+			bool found = false;
+
+			/* Look for a patch position */
+			for ( t=0; !found && ( t < PLACE_TRIES ); t++ ) {
+				/* choose random offset in the selected area of the output image,
+				in its first half so that the part matched is not too small */
+				x = rng.below( ( w + 1 ) / 2 );
+				y = rng.below( ( h + 1 ) / 2 );
+				/* test if enough overlaps, between SELECTED AREA (!)  and patch,
+				and if the part covers a hole, until the texture is finished */
+				c.k = occupancy.sum( ( x + top_leftx ) % t_width, ( y + top_lefty ) % t_height, w - x, h - y );
+				found = ( c.k > 0 ) && ( end() || ( c.k < ( w - x ) * ( h - y ) ) );
 			}
-
-			/* compute final cost */
-			sumr = (int)( sumr / k ); 
-			sumv = (int)( sumv / k ); 
-			sumb = (int)( sumb / k );
-
-			ncost = ( sumr + sumv + sumb ) / 3;
-
-			if ( cost > ncost ) {
-				cost = ncost;
-				bestx = ( x + top_leftx ) % t_width;
-				besty = ( y + top_lefty ) % t_height;
+			/* else the whole area, which overlaps and covers the hole
+			(or nothing does) */
+			if ( !found ) {
+				x = y = 0;
+				c.k = occupancy.sum( top_leftx % t_width, top_lefty % t_height, w, h );
 			}
-
+			c.area = c.pixels = 0;
+			c.valid = ( c.k > 0 );
+			if ( !c.valid )
+				continue;
+
+			/* one good placement found, computes COST  
+			(on the pixels of the current texture in the selected area),
+			reduced as for entire matching if the part pasted covers holes */
+			c.x = ( x + top_leftx ) % t_width;
+			c.y = ( y + top_lefty ) % t_height;
+			c.valid = matchScore( c, i, x, y, w - x, h - y, c.k != ( w - x ) * ( h - y ), best_cost, best_i );
+		}
 	}
 
-	pos.push_back( bestx );
-	pos.push_back( besty );
+	best = bestCandidate( cand );
+	if ( best < 0 )
+		return placeRandom();
+
+	/* the patch has its top-left corner on the area's one,
+	the part matched starts at the best offset */
+	uint_t bestx = ( cand[ best ].x + t_width - top_leftx ) % t_width;
+	uint_t besty = ( cand[ best ].y + t_height - top_lefty ) % t_height;
+
+	pos.x = top_leftx;
+	pos.y = top_lefty;
 	/* nb of pixels overlapping */
-	pos.push_back( 0 );
+	pos.k = cand[ best ].k;
 	/* add width limits */
-	pos.push_back( 0 );
-	pos.push_back( p_width ); //(bot_rightx-bestx) % t_width );
+	pos.x0 = bestx;
+	pos.x1 = w;
 	/* add height limits */
-	pos.push_back( 0 );
-	pos.push_back( p_height ); //(bot_righty-besty) % t_height );
+	pos.y0 = besty;
+	pos.y1 = h;
 
 	return pos;
 }
 
 
-vector < uint_t > Args::place() {
+Args::place_t Args::place() {
 	/*
 	Return a position for a new patch.
 	*/
@@ -370,6 +704,10 @@ vector < uint_t > Args::place() {
 	/* If required, randomly rotate image */
 	if ( k_rot ) {
 		img_in->rotate( 90 * (int) ( 4* ( (float)rand() / RAND_MAX) )  );    
+		fft_patch = false;
+		pyr_patch = false;
+		pm_patch = false;
+		desc_patch = false;
 	}
 	/* If required, randomly mirror image */
 	if ( k_mir ) {
@@ -378,12 +716,24 @@ vector < uint_t > Args::place() {
 			img_in->mirror( 'x' );
 		else if ( g ==1 )
 			img_in->mirror( 'y' );
+		fft_patch = false;
+		pyr_patch = false;
+		pm_patch = false;
+		desc_patch = false;
 	}
 
 	if ( placement == P1 )
 		return placeRandom();
 	else if ( placement == P2 )
 		return placeEntireMatching();
+	else if ( placement == P4 )
+		return placeEntireFFT();
+	else if ( placement == P5 )
+		return placePyramid();
+	else if ( placement == P6 )
+		return placeProbabilistic();
+	else if ( placement == P7 )
+		return placePatchMatch();
 	return placeSubMatching();
 }
 
@@ -440,9 +790,64 @@ void Args::getArgs( vector<string> vargs ) {
 				fatal( "missing argument" );
 
 			cost_reduction = (int) atoi( (*p).c_str() );
-			if ( ( cost_reduction < 10 ) || ( cost_reduction > 30 ) )
+			if ( cost_reduction < 0 )
+				fatal( "invalid cost reduction." );
+			if ( ( cost_reduction != 0 )
+				 && ( ( cost_reduction < 10 ) || ( cost_reduction > 30 ) ) )
 				nonfatal( "warning: cost reduction may be too large or too small." );
 		}
+		else if ( *p == OPT_JOBS ) {
+
+			p++;
+			if ( p == vargs.end() ) 
+				fatal( "missing argument" );
+
+			nb_jobs = (int) atoi( (*p).c_str() );
+			if ( ( nb_jobs < 1 ) || ( nb_jobs > MAX_JOBS ) )
+				fatal( "invalid number of threads." );
+#ifndef _OPENMP
+			if ( nb_jobs > 1 )
+				nonfatal( "warning: compiled without OpenMP, running on one thread." );
+#endif
+		}
+		else if ( *p == OPT_BATCH ) {
+
+			p++;
+			if ( p == vargs.end() ) 
+				fatal( "missing argument" );
+
+			nb_batch = (uint_t) atoi( (*p).c_str() );
+			if ( ( nb_batch < 1 ) || ( nb_batch > MAX_BATCH ) )
+				fatal( "invalid batch size." );
+		}
+		else if ( *p == OPT_PROBK ) {
+
+			p++;
+			if ( p == vargs.end() ) 
+				fatal( "missing argument" );
+
+			prob_k = (float) atof( (*p).c_str() );
+			if ( prob_k <= 0 )
+				fatal( "k must be positive." );
+		}
+		else if ( *p == OPT_GRID ) {
+
+			graph_solver = GRAPH_GRID;
+		}
+		else if ( *p == OPT_GRIDBENCH ) {
+
+			graph_bench = true;
+		}
+		else if ( *p == OPT_PRUNE ) {
+
+			p++;
+			if ( p == vargs.end() ) 
+				fatal( "missing argument" );
+
+			prune_ratio = (float) atof( (*p).c_str() );
+			if ( ( prune_ratio <= 0 ) || ( prune_ratio > 1 ) )
+				fatal( "the pruning ratio must be in ]0,1]." );
+		}
 		else if ( *p == OPT_RATIO ) {
 
 			p++;
@@ -474,6 +879,34 @@ void Args::getArgs( vector<string> vargs ) {
 			placed = true;
 			placement = P3;
 		}
+		else if ( *p == OPT_PLACE_ENTFFT ) {
+
+			if ( placed )
+				fatal("syntax error, you should not specify several placement functions.");
+			placed = true;
+			placement = P4;
+		}
+		else if ( *p == OPT_PLACE_PYRAMID ) {
+
+			if ( placed )
+				fatal("syntax error, you should not specify several placement functions.");
+			placed = true;
+			placement = P5;
+		}
+		else if ( *p == OPT_PLACE_PROB ) {
+
+			if ( placed )
+				fatal("syntax error, you should not specify several placement functions.");
+			placed = true;
+			placement = P6;
+		}
+		else if ( *p == OPT_PLACE_PATCHMATCH ) {
+
+			if ( placed )
+				fatal("syntax error, you should not specify several placement functions.");
+			placed = true;
+			placement = P7;
+		}
 		else if ( *p == OPT_MIRROR ) { k_mir = true; }
 		else if ( *p == OPT_ROTATIO ) { k_rot = true; }
 		else if ( *p == OPT_VERBOSE ) { k_ver = true; }
@@ -507,6 +940,15 @@ void Args::getArgs( vector<string> vargs ) {
 
 	placement0 = placement;
 
+	/* costs reduced to whole numbers are at most 510 / n ( -C1 )
+	or 510 ( -C2 ), and a pixel is cut from its 4 neighbours for
+	less than MAX_SHORT: 16 bits always hold them; exact costs
+	need floats ( GridGraph still takes them rounded ) */
+	if ( cost_reduction == 0 ) {
+		graph_cap = CAP_FLOAT;
+		if ( graph_solver == GRAPH_GRID || graph_bench )
+			nonfatal( "warning: -g and -gb round the exact costs (-C 0)." );
+	}
 }
 
 
@@ -598,7 +1040,7 @@ void Args::openImageOut() {
 	if ( p_width ) {
 		img_out = new cimg_library::CImg< uchar_t > ( xcoef * p_width, 
 			ycoef * p_height, 1, 3 ); 
-		img_msk = new cimg_library::CImg< uint_t > ( xcoef * p_width,
+		img_msk = new cimg_library::CImg< uchar_t > ( xcoef * p_width,
 			ycoef * p_height );
 		img_err = new cimg_library::CImg< uchar_t > ( xcoef * p_width,
 			ycoef * p_height, 1, 3 );
@@ -612,6 +1054,10 @@ void Args::openImageOut() {
 		t_height = img_out->dimy();
 		total_pixels = t_width * t_height;
 
+		occupancy.init( t_width, t_height );
+		unfilled.init( t_width, t_height );
+		img_src.assign( t_width * t_height, MAX_UINT32 );
+
 		/* Initialize old seam databases */
 		for( size_t i=0; i < t_width * t_height; i++ ) {
 
@@ -676,6 +1122,10 @@ void Args::usage() {
 	cout << "\t-P1\tRandom placement." << endl;
 	cout << "\t-P2\tEntire patch matching ." << endl;
 	cout << "\t-P3\tSub-patch matching (default)." << endl;
+	cout << "\t-P4\tExhaustive entire patch matching (FFT)." << endl;
+	cout << "\t-P5\tCoarse to fine entire patch matching (pyramid)." << endl;
+	cout << "\t-P6\tProbabilistic entire patch matching (FFT)." << endl;
+	cout << "\t-P7\tEntire patch matching (PatchMatch, k-coherence)." << endl;
 
 	cout << "Output type:" << endl;
 	cout << "\tSpecify either -BMP (default), -JPG, or -PNG." << endl; 
@@ -685,10 +1135,16 @@ void Args::usage() {
 	cout << "\t-r\tRandomly rotate the patch while texturing." << endl;
 
 	cout << "Other options:" << endl;
-	cout << "\t-C n\tSpecify reduction applyed to edges costs (default: 20)." << endl;
+	cout << "\t-C n\tSpecify reduction applyed to edges costs (default: 20, 0: exact costs)." << endl;
 	cout << "\t-cx n\tSpecify texture width coefficient." << endl;
 	cout << "\t-cy n\tSpecify texture height coefficient." << endl;
 	cout << "\t-h\tDisplay this help informations." << endl;
+	cout << "\t-j n\tEvaluate matching placements, and cut large graphs, on n threads (default: 1)." << endl;
+	cout << "\t-b n\tPlace and cut n patches per iteration (default: 1)." << endl;
+	cout << "\t-g\tUse the grid maxflow solver." << endl;
+	cout << "\t-gb\tRun both maxflow solvers and compare them (verbose mode)." << endl;
+	cout << "\t-k x\tRandomness of probabilistic placement (default: 0.01)." << endl;
+	cout << "\t-q x\tFraction of entire matching candidates kept by the prefilter (default: 0.25)." << endl;
 	cout << "\t-o f\tOutput texture to the given file (do not give extension)." << endl;
 	cout << "\t-pc\tInitial position at top-left corner." << endl;
 	cout << "\t-pr\tInitial random position (default)." << endl;
@@ -728,6 +1184,38 @@ void Args::status() {
 }
 
 
+void Args::ssdReport() {
+	/*
+	Display the share of the candidates SSD given up
+	by the matching placements.
+	*/
+	if ( ssd_total == 0 )
+		return;
+	cout << ":: SSD abandoned: " << ssd_total - ssd_done << "/" << ssd_total
+		<< " pixels (" << (int) ( 100.0 * ( ssd_total - ssd_done ) / ssd_total ) << "%)" << endl;
+}
+
+
+void Args::graphReport() {
+	/*
+	Display the time spent by both maxflow solvers
+	on the same graphs ( benchmark ), and by Graph on
+	the threads.
+	*/
+	if ( flow_graphs == 0 )
+		return;
+	cout << ":: Maxflow on " << flow_graphs << " graphs: Graph "
+		<< (double) flow_time[ GRAPH_BK ] / CLOCKS_PER_SEC << " s, GridGraph "
+		<< (double) flow_time[ GRAPH_GRID ] / CLOCKS_PER_SEC << " s" << endl;
+	if ( flow_diff )
+		cout << ":: Maxflow: flows differ on " << flow_diff << " graphs!" << endl;
+	if ( nb_jobs > 1 )
+		cout << ":: Maxflow on " << nb_jobs << " threads: Graph "
+			<< (double) par_time / CLOCKS_PER_SEC << " s of CPU, cuts differ from one thread on "
+			<< par_diff << " graphs" << endl;
+}
+
+
 bool Args::end() {
 
 	return finished;
@@ -41,6 +41,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "main.h"
 #include "graph.h"
+#include "gridgraph.h"
+#include "fft.h"
+#include "sat.h"
+#include "ssd.h"
+#include "rng.h"
+#include "alias.h"
+#include "holes.h"
 
 #include <stdlib.h>
 #include <math.h>
@@ -69,15 +76,98 @@ use a fastest place function (ie placeRandom) */
 #define OPT_BMP "-BMP" /* output in BMP format */
 #define OPT_JPG "-JPG" /* output in BMP format */
 #define OPT_PNG "-PNG" /* output in BMP format */
+#define OPT_JOBS "-j" /* number of threads */
+#define OPT_PROBK "-k" /* randomness of probabilistic placement */
+#define OPT_PRUNE "-q" /* candidates of entire matching kept by the prefilter */
+#define OPT_BATCH "-b" /* patches placed and cut per iteration */
+#define OPT_GRID "-g" /* grid maxflow solver */
+#define OPT_GRIDBENCH "-gb" /* both maxflow solvers, compared */
 
 #define OPT_PLACE_RANDOM "-P1"
 #define OPT_PLACE_ENTMAT "-P2"
 #define OPT_PLACE_SUBMAT "-P3"
+#define OPT_PLACE_ENTFFT "-P4"
+#define OPT_PLACE_PYRAMID "-P5"
+#define OPT_PLACE_PROB "-P6"
+#define OPT_PLACE_PATCHMATCH "-P7"
 
 /* Number of tests for matching placements */
 #define PLACE_ENTM_TESTS 100
 #define PLACE_SUBM_TESTS 100
 
+/* Patch spectra */
+#define SPEC_WIN 0
+#define SPEC_SQ 1
+#define SPEC_RED 2
+#define SPEC_GREEN 3
+#define SPEC_BLUE 4
+
+/* Cost maps are computed in full again after MAP_REFRESH local
+updates (rounding errors), or when more than MAP_MAX_DIRTY rects
+changed in between */
+#define MAP_REFRESH 64
+#define MAP_MAX_DIRTY 8
+
+/* Pyramid matching: number of offsets kept per level,
+neighbourhood searched around them on the next level,
+size of the coarsest patch and max number of levels */
+#define PYR_CANDIDATES 8
+#define PYR_RADIUS 2
+#define PYR_MIN_SIZE 8
+#define PYR_MAX_LEVELS 6
+
+/* Probabilistic placement: offsets are drawn with probability
+exp( -C / ( k.sigma^2 ) ), C their cost and sigma^2 the variance
+of the patch colours; k defaults to PROB_K */
+#define PROB_K 0.01
+
+/* Random draws aimed at holes, or at areas of sub-patch matching,
+before taking an offset from the list of valid ones */
+#define PLACE_TRIES 64
+
+/* PatchMatch placement: similar windows kept per patch pixel
+(k-coherence), their size, passes to compute them, and texture
+pixels sampled around the hole to get candidate offsets */
+#define PM_K 4
+#define PM_WIN 5
+#define PM_ITERS 4
+#define PM_SAMPLES 32
+
+/* Descriptor prefilter of entire matching: cells per side of
+the patch, fraction of the candidates kept for the exact SSD
+( 1: no prefilter ), tables (3 colours and gradient energy) */
+#define DESC_CELLS 8
+#define PRUNE_RATIO 0.25
+#define DESC_TABLES 4
+#define DESC_GRAD 3
+
+/* Rows summed between two checks of the best-so-far bound */
+#define SSD_STRIP 8
+
+/* Max number of threads for matching placements */
+#define MAX_JOBS 256
+
+/* Batches of placements: max size, pixels kept between two
+(sub)patches of a batch, positions dropped in a row before
+closing it */
+#define MAX_BATCH 256
+#define BATCH_MARGIN 1
+#define BATCH_TRIES 4
+
+/* Graphs of at least PAR_NODES nodes, alone in their batch, are
+cut on the threads of -j ( see Graph::maxflow_parallel() ) */
+#define PAR_NODES 65536
+
+/* Maxflow solvers: Graph ( any graph ), GridGraph ( the overlap
+grid, see gridgraph.h ) */
+#define GRAPH_BK 0
+#define GRAPH_GRID 1
+
+/* Capacities of the Graph solver: 16 bits for the costs reduced
+to small integers ( -C n ), floats for the exact ones ( -C 0 ) */
+#define CAP_16 0
+#define CAP_FLOAT 1
+
 /* Cost functions */
 #define OPT_COST1 "-C1"
 #define OPT_COST2 "-C2"
@@ -85,10 +175,16 @@ use a fastest place function (ie placeRandom) */
 #define XCOEF 3
 #define YCOEF 3
 
-/* Placements: Random, Entire matching Sub-matching */
+/* Placements: Random, Entire matching Sub-matching,
+Exhaustive entire matching, Pyramid matching,
+Probabilistic entire matching, PatchMatch */
 #define P1 1
 #define P2 2
 #define P3 3
+#define P4 4
+#define P5 5
+#define P6 6
+#define P7 7
 
 /* Cost function used */
 #define C1 0  /* basic function */
@@ -113,6 +209,11 @@ use a fastest place function (ie placeRandom) */
 /* bonus on the seam->source edges */
 #define SEAM_BONUS 1
 
+/* terminal links of the overlap pixels ( see graphBorders() ) */
+#define BORDER_NONE   0
+#define BORDER_SINK   1
+#define BORDER_SOURCE 2
+
 /* number of refinement stages */
 #define REF_ITERS 10
 
@@ -125,6 +226,51 @@ class Args {
 
 public:
 	typedef uint_t pixel_t [2];
+	/* edge cost, a whole number but with exact costs ( -C 0 ) */
+	typedef float cost_t;
+
+	/* one offset tried by a matching placement */
+	struct candidate_t {
+		uint_t x, y; /* position on the texture */
+		uint_t k; /* #pixels overlapping */
+		float cost; /* matching cost */
+		bool valid; /* false if not to be placed */
+		uint_t area; /* pixels of the SSD window */
+		uint_t pixels; /* pixels of the SSD actually summed */
+	};
+
+	/* position of a new patch ( see place() ) */
+	struct place_t {
+		uint_t x, y; /* top-left corner of the patch on the texture */
+		uint_t k; /* #pixels overlapping */
+		uint_t x0, x1; /* X limits of the (sub)patch, in the patch */
+		uint_t y0, y1; /* Y limits of the (sub)patch, in the patch */
+	};
+
+	/* candidate index, ordered by descriptor distance */
+	struct desc_order_t {
+		float dist;
+		int i;
+		bool operator < ( const desc_order_t & o ) const {
+			return ( dist < o.dist ) || ( ( dist == o.dist ) && ( i < o.i ) );
+		}
+	};
+
+	/* texture rect, wrapping around the borders */
+	struct rect_t {
+		uint_t x, y, w, h;
+	};
+
+	/* edge costs of the (sub)patch of a position, all computed
+	at once before building its graph ( see graphCosts() );
+	planes of w x h values, row by row */
+	struct edge_costs_t {
+		vector< uchar_t > tex; /* texture under the (sub)patch, 3 planes */
+		vector< cost_t > left; /* pixel to its left neighbour */
+		vector< cost_t > top; /* pixel to its top neighbour */
+		vector< uchar_t > msk; /* mask under the (sub)patch, then eroded */
+		vector< uchar_t > border; /* terminal link of the pixel, BORDER_* */
+	};
 
 protected:
 
@@ -162,8 +308,10 @@ protected:
 	/* set to true when no more empty pixel */
 	bool finished;
 
-	/* current set of nodes */
-	vector < Graph::node_id > nodes;
+	/* current set of nodes, and node index + 1 of the pixels
+	under the (sub)patch ( see graphCreate() ) */
+	vector < Graph16::node_id > nodes;
+	vector< uint_t > node_labels;
 
 	/* INPUT AND OUTPUT IMAGES */
 
@@ -171,8 +319,23 @@ protected:
 	cimg_library::CImg< uchar_t> * img_in;
 	/* final texture ( larger ), @see XCOEF, YCOEF */
 	cimg_library::CImg< uchar_t > * img_out;
-	/* binary mask to mark pixels already colored */
-	cimg_library::CImg< uint_t > * img_msk;
+	/* binary mask to mark pixels already colored ( 0 or 255 ) */
+	cimg_library::CImg< uchar_t > * img_msk;
+	/* same mask (0/1) with its summed-area table, to count
+	the pixels set under any window in O(1) */
+	SumTable< uint_t > occupancy;
+	/* index of the pixels not set yet, to aim patches at holes */
+	HoleIndex unfilled;
+	/* offsets where a patch overlaps enough ( map, and count per
+	row and in all ), rects filled since they were updated, state
+	of end() then, set when none was found and reported */
+	vector< uchar_t > valid_map;
+	vector< uint_t > valid_rows;
+	uint_t valid_count;
+	vector< rect_t > valid_dirty;
+	bool valid_done;
+	bool valid_end;
+	bool valid_warned;
 	/* error image, to draw seams */
 	cimg_library::CImg< uchar_t > * img_err;
 	/* image to remember top (vertical) seams  (continuous indexing) */
@@ -188,6 +351,120 @@ protected:
 
 	/* list of 256 first squares, to speed up placement cost computation */
 	int squares [256]; 
+	/* square roots of the gradients of graphCostGradi() ( 1 to 511 ) */
+	float grad_sqrt [512];
+	/* masked SSD kernel selected for this CPU */
+	int ssd_kernel;
+	/* number of threads evaluating placement candidates */
+	int nb_jobs;
+	/* number of patches placed per iteration */
+	uint_t nb_batch;
+	/* maxflow solver ( GRAPH_BK, GRAPH_GRID ); with graph_bench,
+	both are run, and their time and flows compared */
+	char graph_solver;
+	bool graph_bench;
+	/* capacities of Graph ( CAP_16, CAP_FLOAT ), from the costs */
+	char graph_cap;
+	clock_t flow_time[2];
+	uint_t flow_graphs;
+	uint_t flow_diff;
+	/* with graph_bench and nb_jobs > 1, Graph is also run on the
+	threads ( CPU time of all of them ), and its cuts compared */
+	clock_t par_time;
+	uint_t par_diff;
+	/* graphs of a batch and their sets of nodes, kept from one
+	iteration to the next ( see Graph::reset() ) */
+	vector< Graph16 * > graphs_bk;
+	vector< GraphFloat * > graphs_float;
+	vector< GridGraph * > graphs_grid;
+	vector< vector< Graph16::node_id > > sets_bk;
+	vector< vector< GraphFloat::node_id > > sets_float;
+	vector< vector< GridGraph::node_id > > sets_grid;
+	vector< edge_costs_t > costs_slots; /* one per batch position */
+	vector< vector< uint_t > > label_slots; /* idem */
+	/* candidates of the matching placements, kept between placements */
+	vector< candidate_t > candidates;
+	/* positions returned by placeBatch() */
+	vector< place_t > place_batch;
+	/* edge costs of the current position */
+	edge_costs_t edge_costs;
+	/* pixels of the candidates SSD windows, and pixels summed
+	before giving up ( verbose mode ) */
+	unsigned long long ssd_total;
+	unsigned long long ssd_done;
+
+	/* EXHAUSTIVE MATCHING ( cost of every offset, by FFT ) */
+
+	FFT2D fft;
+	/* set when the patch spectra match img_in */
+	bool fft_patch;
+	/* conjugated spectra of the patch window, sum of squared
+	channels, and channels ( see SPEC_WIN ... SPEC_BLUE ) */
+	vector< cplx_t > spec_patch[5];
+	/* work buffers for the texture spectra */
+	vector< cplx_t > spec_tex[4];
+	/* masked SSD and number of overlapping pixels, per offset */
+	vector< double > cost_map;
+	vector< uint_t > count_map;
+
+	/* the same patch spectra, for the local updates of the maps
+	( (2.p_width-1) x (2.p_height-1) ) */
+	FFT2D fft_local;
+	bool fft_local_patch;
+	vector< cplx_t > spec_local[5];
+	/* texture seen by the maps (channels and mask), rects
+	changed since, and number of local updates since the maps were
+	last computed in full */
+	cimg_library::CImg< uchar_t > map_out;
+	vector< rect_t > map_dirty;
+	bool map_valid;
+	uint_t map_updates;
+
+	/* PYRAMID MATCHING ( coarse to fine search ) */
+
+	/* patch and texture levels, [0] at full resolution; texture
+	levels hold the colours weighted by the mask, and the mask */
+	vector< cimg_library::CImg< float > > pyr_in;
+	vector< cimg_library::CImg< float > > pyr_out;
+	/* set when pyr_in matches img_in */
+	bool pyr_patch;
+
+	/* PROBABILISTIC MATCHING ( offsets drawn from the cost map ) */
+
+	float prob_k;
+	/* variance of the patch colours, < 0 until computed */
+	double prob_var;
+	/* weight of every offset, and the table to draw them */
+	vector< double > prob_weights;
+	AliasTable prob_table;
+
+	/* PATCHMATCH ( k-coherence candidates ) */
+
+	/* patch pixel (j.p_width + i) copied on every texture
+	pixel, MAX_UINT32 where none */
+	vector< uint_t > img_src;
+	/* for every patch pixel, the PM_K most similar windows
+	of the patch, and their distances, closest first */
+	vector< uint_t > pm_knn;
+	vector< uint_t > pm_dist;
+	/* set when pm_knn matches img_in */
+	bool pm_patch;
+
+	/* DESCRIPTOR PREFILTER ( summed-area tables of colours and
+	gradient energy, of the patch and of the texture pixels set ) */
+
+	float prune_ratio;
+	SumTable< unsigned long long > desc_in[ DESC_TABLES ];
+	SumTable< unsigned long long > desc_out[ DESC_TABLES ];
+	/* set when desc_in matches img_in, and desc_out is up to
+	date but for the rects of desc_dirty */
+	bool desc_patch;
+	bool desc_valid;
+	vector< rect_t > desc_dirty;
+	/* candidates ordered by descPrune(), and indices of
+	those it kept ( kept between placements ) */
+	vector< desc_order_t > desc_order;
+	vector< int > desc_kept;
 
 public:
 
@@ -214,21 +491,53 @@ public:
 		p_width = p_height = 0;
 
 		nb_refinements = 0;
+		nb_jobs = 1;
+		nb_batch = 1;
+		graph_solver = GRAPH_BK;
+		graph_bench = false;
+		graph_cap = CAP_16;
+		flow_time[ GRAPH_BK ] = flow_time[ GRAPH_GRID ] = 0;
+		flow_graphs = flow_diff = 0;
+		par_time = 0;
+		par_diff = 0;
+		ssd_total = ssd_done = 0;
+		valid_count = 0;
+		valid_done = false;
+		valid_end = false;
+		valid_warned = false;
 
 		total_pixels = 0;
 		nb_pixels = 0;
 		finished = false;
 
+		fft_patch = false;
+		fft_local_patch = false;
+		map_valid = false;
+		map_updates = 0;
+		pyr_patch = false;
+		prob_k = (float) PROB_K;
+		prob_var = -1;
+		pm_patch = false;
+		prune_ratio = (float) PRUNE_RATIO;
+		desc_patch = false;
+		desc_valid = false;
+
 		xcoef = XCOEF;
 		ycoef = YCOEF;
 		cost_reduction = COST_REDUC;
 		ratio = OVERLAP_RATIO;
 
 		/* initialize square */
-		for( int i=1; i < 256; i++ ) {
+		for( int i=0; i < 256; i++ ) {
 			squares[ i ] = i * i;
 		}
+		for( int i=0; i < 512; i++ ) {
+			grad_sqrt[ i ] = sqrt( (float) i );
+		}
+
 
+		/* select the SSD kernel */
+		ssd_kernel = ssdInit();
 
 		/* init random seed */
 		initRandom();
@@ -237,7 +546,17 @@ public:
 
 	/* DESTRUCTOR */
 
-	~Args() {}
+	~Args() {
+
+		uint_t i;
+
+		for ( i=0; i < graphs_bk.size(); i++ )
+			delete graphs_bk[ i ];
+		for ( i=0; i < graphs_float.size(); i++ )
+			delete graphs_float[ i ];
+		for ( i=0; i < graphs_grid.size(); i++ )
+			delete graphs_grid[ i ];
+	}
 
 
 	/* GETTERS / SETTERS */
@@ -273,17 +592,31 @@ public:
 
 	int nbRef() { return nb_refinements; };
 
+	const char * ssdKernel() { return ssdName( ssd_kernel ); };
+
+	int nbJobs() { return nb_jobs; };
+
+	uint_t batchSize() { return nb_batch; };
+
 	/* OTHER METHODS' PRIMITIVES */
 
-	void graphCreate( Graph * G, vector< uint_t > pos );
+	void graphCreate( Graph16 * G, const place_t & pos ) { graphCreate( G, pos, nodes, edge_costs, node_labels ); };
+
+	Graph16::flowtype graphMaxFlow( Graph16 * G, int jobs = 1 );
 
-	Graph::flowtype graphMaxFlow( Graph * G );
+	GraphFloat::flowtype graphMaxFlow( GraphFloat * G, int jobs = 1 );
 
-	int graphCutSeam( Graph * G, vector< uint_t > pos );
+	GridGraph::flowtype graphMaxFlow( GridGraph * G, int jobs = 1 );
 
-	vector< uint_t > placeInit();
+	int graphCutSeam( Graph16 * G, const place_t & pos ) { return graphCutSeam( G, pos, nodes, node_labels ); };
 
-	vector< uint_t > place();
+	const vector< place_t > & placeBatch();
+
+	void graphBatch( const vector< place_t > & batch );
+
+	place_t placeInit();
+
+	place_t place();
 
 	void getArgs( vector< string > vargs );
 
@@ -311,46 +644,147 @@ public:
 
 	void status();
 
+	void ssdReport();
+
+	void graphReport();
+
 	bool end();
 
 
 protected:
 
-	Graph::captype graphCost( uint_t * s, uint_t * t,  vector< uint_t > offset );
+	/* graph of a position, with its own set of nodes
+	( GT: Graph16, GraphFloat or GridGraph ) */
+	template < class GT >
+	void graphCreate( GT * G, const place_t & pos, vector< typename GT::node_id > & nodes,
+		edge_costs_t & costs, vector< uint_t > & labels );
+
+	void graphCosts( const place_t & pos, edge_costs_t & costs );
+
+	void graphBorders( const place_t & pos, edge_costs_t & costs );
+
+	template < class GT >
+	int graphCutSeam( GT * G, const place_t & pos, vector< typename GT::node_id > & nodes,
+		const vector< uint_t > & labels );
+
+	template < class GT >
+	void graphSolve( const vector< place_t > & batch );
+
+	/* graphs and sets of nodes kept for a solver */
+	vector< Graph16 * > & graphSlots( Graph16 * ) { return graphs_bk; };
+	vector< GraphFloat * > & graphSlots( GraphFloat * ) { return graphs_float; };
+	vector< GridGraph * > & graphSlots( GridGraph * ) { return graphs_grid; };
+	vector< vector< Graph16::node_id > > & nodeSlots( Graph16 * ) { return sets_bk; };
+	vector< vector< GraphFloat::node_id > > & nodeSlots( GraphFloat * ) { return sets_float; };
+	vector< vector< GridGraph::node_id > > & nodeSlots( GridGraph * ) { return sets_grid; };
+
+	void graphBench( const place_t & pos );
+
+	cost_t graphCost( uint_t * s, uint_t * t,  const place_t & offset );
 
-	Graph::captype graphCostBasic( uint_t * s, uint_t * t,  vector< uint_t > offset, int reduction );
+	cost_t graphCostBasic( uint_t * s, uint_t * t,  const place_t & offset, int reduction );
 
-	Graph::captype graphCostGradi( uint_t * s, uint_t * t,  vector< uint_t > offset );
+	cost_t graphCostGradi( uint_t * s, uint_t * t,  const place_t & offset );
 
-	Graph::captype graphCost( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+	cost_t graphCost( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 		uchar_t s2r, uchar_t s2v, uchar_t s2b,
 		uchar_t t1r, uchar_t t1v, uchar_t t1b,
 		uchar_t t2r, uchar_t t2v, uchar_t t2b
 		);
 
-	Graph::captype graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+	cost_t graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 		uchar_t s2r, uchar_t s2v, uchar_t s2b,
 		uchar_t t1r, uchar_t t1v, uchar_t t1b,
 		uchar_t t2r, uchar_t t2v, uchar_t t2b,
 		int reduction );
 
-	Graph::captype graphCostGradi( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+	cost_t graphCostGradi( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 		uchar_t s2r, uchar_t s2v, uchar_t s2b,
 		uchar_t t1r, uchar_t t1v, uchar_t t1b,
 		uchar_t t2r, uchar_t t2v, uchar_t t2b
 		);
 
-	bool borderPatch( vector< uint_t > pos, uint_t x, uint_t y );
-
-	bool borderTexture( vector< uint_t > pos, uint_t x, uint_t y );
+	/* next column / row of the toroidal texture, so that the
+	   loops over a wrapping rect need no modulo per pixel */
+	uint_t nextX( uint_t x ) { return ( x + 1 == t_width ) ? 0 : x + 1; };
+	uint_t nextY( uint_t y ) { return ( y + 1 == t_height ) ? 0 : y + 1; };
 
 	void initRandom();
 
-	vector< uint_t > placeRandom();
+	void ssdWindow( uint_t x, uint_t y, uint_t px, uint_t py,
+		uint_t w, uint_t h, unsigned long long * sums );
+
+	void ssdRows( uint_t x, uint_t y, uint_t px, uint_t py,
+		uint_t w, uint_t j0, uint_t j1, unsigned long long * sums );
+
+	unsigned long long candidateSeed();
+
+	int bestCandidate( const vector< candidate_t > & cand );
+
+	float matchCost( const unsigned long long * sums, uint_t k, bool holes );
+
+	bool matchScore( candidate_t & c, int i, uint_t px, uint_t py,
+		uint_t w, uint_t h, bool holes, float & best_cost, int & best_i );
+
+	bool lastHoles() { return unfilled.size() <= p_width * p_height; };
+
+	void targetHole( RandomStream & rng, uint_t & x, uint_t & y );
+
+	void validOffsets();
+
+	void validDirty( uint_t x, uint_t y, uint_t w, uint_t h );
+
+	void validSet( uint_t x, uint_t y );
+
+	uint_t validOffset( uint_t i );
+
+	bool sampleOffset( RandomStream & rng, uint_t & x, uint_t & y );
+
+	place_t placeRandom();
+
+	place_t placeEntireMatching();
+
+	place_t placeSubMatching();
+
+	void patchSpectra( FFT2D & f, vector< cplx_t > * spec );
+
+	void textureTerms( uint_t part, cplx_t * z, uint_t fw, uint_t fh,
+		uint_t x0, uint_t y0, uint_t u0, uint_t v0, uint_t w, uint_t h, bool delta );
+
+	void correlate( FFT2D & f, vector< cplx_t > * spec,
+		uint_t x0, uint_t y0, uint_t u0, uint_t v0, uint_t w, uint_t h, bool delta );
+
+	void costMap();
+
+	void costMapDirty( uint_t x, uint_t y, uint_t w, uint_t h );
+
+	place_t placeEntireFFT();
+
+	void pyramid();
+
+	void pyramidCost( uint_t l, candidate_t & c );
+
+	place_t placePyramid();
+
+	place_t placeProbabilistic();
+
+	uint_t pmDistance( uint_t q, uint_t s, uint_t bound );
+
+	void pmInsert( uint_t q, uint_t s );
+
+	void pmTable();
+
+	place_t placePatchMatch();
+
+	void descPixel( uint_t x, uint_t y );
+
+	void descriptors();
+
+	void descDirty( uint_t x, uint_t y, uint_t w, uint_t h );
 
-	vector< uint_t > placeEntireMatching();
+	float descDistance( uint_t x, uint_t y );
 
-	vector< uint_t > placeSubMatching();
+	void descPrune( vector< candidate_t > & cand );
 
 };
 
@@ -0,0 +1,259 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* argsbatch.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "args.h"
+#include "graph.h"
+#include "gridgraph.h"
+
+
+static bool batchMeet( uint_t a, uint_t la, uint_t b, uint_t lb, uint_t size ) {
+	/*
+	Whether [a,a+la) and [b,b+lb) meet, modulo size.
+	*/
+	if ( ( la >= size ) || ( lb >= size ) )
+		return true;
+	return ( ( b + size - a ) % size < la ) || ( ( a + size - b ) % size < lb );
+}
+
+
+static bool batchMeet( const Args::place_t & p, const Args::place_t & q,
+					  uint_t width, uint_t height ) {
+	/*
+	Whether the (sub)patches at positions p and q, grown
+	by BATCH_MARGIN pixels, meet on the texture.
+	*/
+	uint_t m = BATCH_MARGIN;
+
+	return batchMeet( ( p.x + p.x0 + width - m ) % width, p.x1 - p.x0 + 2 * m,
+			( q.x + q.x0 + width - m ) % width, q.x1 - q.x0 + 2 * m, width )
+		&& batchMeet( ( p.y + p.y0 + height - m ) % height, p.y1 - p.y0 + 2 * m,
+			( q.y + q.y0 + height - m ) % height, q.y1 - q.y0 + 2 * m, height );
+}
+
+
+/************/
+/* POSITION */
+/************/
+
+
+const vector< Args::place_t > & Args::placeBatch() {
+	/*
+	Return up to nb_batch positions (see place()) whose
+	(sub)patches, grown by BATCH_MARGIN pixels, do not
+	meet: each graph then only reads and writes its own
+	pixels. A position which meets one already taken
+	is dropped, and the batch closed after BATCH_TRIES
+	positions dropped in a row.
+	With rotations or mirrors, the patch changes at every
+	placement, so that a batch holds one position.
+	The batch is kept until the next call.
+	*/
+	vector< place_t > & batch = place_batch;
+	uint_t n = ( k_rot || k_mir ) ? 1 : nb_batch;
+	uint_t b, dropped = 0;
+
+	batch.clear();
+	while ( ( batch.size() < n ) && ( dropped < BATCH_TRIES ) ) {
+
+		place_t pos = place();
+
+		for ( b=0; b < batch.size(); b++ )
+			if ( batchMeet( pos, batch[ b ], t_width, t_height ) )
+				break;
+
+		if ( b < batch.size() ) {
+			dropped++;
+		}
+		else {
+			batch.push_back( pos );
+			dropped = 0;
+		}
+	}
+	return batch;
+}
+
+
+/*********/
+/* GRAPH */
+/*********/
+
+
+template < class C, class F >
+static void graphReset( Graph< C, F > * G, const Args::place_t & ) {
+
+	G->reset();
+}
+
+
+static void graphReset( GridGraph * G, const Args::place_t & pos ) {
+	/*
+	The grid is the (sub)patch.
+	*/
+	G->reset( pos.x1 - pos.x0, pos.y1 - pos.y0 );
+}
+
+
+void Args::graphBatch( const vector< place_t > & batch ) {
+	/*
+	Cut a batch of positions with the maxflow solver selected.
+	*/
+	uint_t b;
+
+	if ( graph_bench ) {
+		for ( b=0; b < batch.size(); b++ )
+			graphBench( batch[ b ] );
+	}
+	else if ( graph_solver == GRAPH_GRID )
+		graphSolve< GridGraph >( batch );
+	else if ( graph_cap == CAP_FLOAT )
+		graphSolve< GraphFloat >( batch );
+	else
+		graphSolve< Graph16 >( batch );
+}
+
+
+template < class GT >
+void Args::graphSolve( const vector< place_t > & batch ) {
+	/*
+	Build and solve the graphs of a batch of positions
+	(see placeBatch()) on nb_jobs threads, then copy the
+	pixels cut in the order of the batch, so that the
+	texture does not depend on the threads. A batch of one
+	position cuts its graph on the threads instead, if large.
+	The graphs are reset and built again at each batch:
+	their memory is allocated during the first ones only.
+	*/
+	int n = (int) batch.size(), i;
+	vector< GT * > & graphs = graphSlots( (GT *) 0 );
+	vector< vector< typename GT::node_id > > & sets = nodeSlots( (GT *) 0 );
+
+	while ( (int) graphs.size() < n )
+		graphs.push_back( new GT );
+	if ( (int) sets.size() < n )
+		sets.resize( n );
+	if ( (int) costs_slots.size() < n )
+		costs_slots.resize( n );
+	if ( (int) label_slots.size() < n )
+		label_slots.resize( n );
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule( dynamic ) num_threads( nb_jobs ) if( n > 1 )
+#endif
+	for ( i=0; i < n; i++ ) {
+
+		graphReset( graphs[ i ], batch[ i ] );
+		graphCreate( graphs[ i ], batch[ i ], sets[ i ], costs_slots[ i ], label_slots[ i ] );
+		graphMaxFlow( graphs[ i ], ( n == 1 ) ? nb_jobs : 1 );
+	}
+
+	for ( i=0; i < n; i++ ) {
+
+		graphCutSeam( graphs[ i ], batch[ i ], sets[ i ], label_slots[ i ] );
+	}
+}
+
+
+
+void Args::graphBench( const place_t & pos ) {
+	/*
+	Build the graph of a position for both solvers, time
+	their maxflow, and check that the flows are the same;
+	with several threads, Graph is also cut on them, which
+	must give the same flow and the same cut as on one.
+	The pixels are cut with Graph.
+	*/
+	Graph16::flowtype f;
+	clock_t t;
+	uint_t i;
+
+	while ( graphs_bk.size() < 2 )
+		graphs_bk.push_back( new Graph16 );
+	if ( sets_bk.size() < 2 )
+		sets_bk.resize( 2 );
+	if ( graphs_grid.empty() ) {
+		graphs_grid.push_back( new GridGraph );
+		sets_grid.resize( 1 );
+	}
+	if ( costs_slots.empty() )
+		costs_slots.resize( 1 );
+	if ( label_slots.empty() )
+		label_slots.resize( 1 );
+
+	Graph16 * G = graphs_bk[0];
+	GridGraph * H = graphs_grid[0];
+	vector< Graph16::node_id > & g_nodes = sets_bk[0];
+	vector< GridGraph::node_id > & h_nodes = sets_grid[0];
+
+	graphReset( G, pos );
+	graphReset( H, pos );
+	graphCreate( G, pos, g_nodes, costs_slots[0], label_slots[0] );
+	graphCreate( H, pos, h_nodes, costs_slots[0], label_slots[0] );
+
+	t = clock();
+	f = graphMaxFlow( G );
+	flow_time[ GRAPH_BK ] += clock() - t;
+
+	t = clock();
+	if ( graphMaxFlow( H ) != f )
+		flow_diff++;
+	flow_time[ GRAPH_GRID ] += clock() - t;
+	flow_graphs++;
+
+	if ( nb_jobs > 1 ) {
+
+		/* whatever its size ( see PAR_NODES ) */
+		Graph16 * P = graphs_bk[1];
+		vector< Graph16::node_id > & p_nodes = sets_bk[1];
+
+		graphReset( P, pos );
+		graphCreate( P, pos, p_nodes, costs_slots[0], label_slots[0] );
+
+		t = clock();
+		if ( P->maxflow_parallel( nb_jobs ) != f )
+			par_diff++;
+		else {
+			for ( i=0; i < g_nodes.size(); i++ )
+				if ( G->what_segment( g_nodes[ i ] ) != P->what_segment( p_nodes[ i ] ) )
+					break;
+			if ( i < g_nodes.size() )
+				par_diff++;
+		}
+		par_time += clock() - t;
+	}
+
+	graphCutSeam( G, pos, g_nodes, label_slots[0] );
+}
@@ -0,0 +1,255 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* argsdesc.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "args.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+/***************/
+/* DESCRIPTORS */
+/***************/
+
+
+static unsigned long long descGradient( int a, int b, int c ) {
+	/*
+	Gradient energy of a pixel of luminance (sum of the
+	channels) a, b being its right and c its bottom
+	neighbour, < 0 where missing.
+	*/
+	unsigned long long g = 0;
+
+	if ( b >= 0 )
+		g += (unsigned long long) ( ( b - a ) * ( b - a ) );
+	if ( c >= 0 )
+		g += (unsigned long long) ( ( c - a ) * ( c - a ) );
+	return g;
+}
+
+
+void Args::descPixel( uint_t x, uint_t y ) {
+	/*
+	Set the descriptor tables of texture pixel (x,y):
+	colours and gradient energy where it is set, 0 else.
+	*/
+	uint_t xr = ( x + 1 ) % t_width, yb = ( y + 1 ) % t_height;
+	int l, lr = -1, lb = -1;
+	uint_t c;
+
+	if ( (*img_msk)( x, y ) == 0 ) {
+		for ( c=0; c < DESC_TABLES; c++ )
+			desc_out[ c ].set( x, y, 0 );
+		return;
+	}
+
+	for ( c=0; c < 3; c++ )
+		desc_out[ c ].set( x, y, (*img_out)( x, y, c ) );
+
+	l = (*img_out)( x, y, 0 ) + (*img_out)( x, y, 1 ) + (*img_out)( x, y, 2 );
+	if ( (*img_msk)( xr, y ) != 0 )
+		lr = (*img_out)( xr, y, 0 ) + (*img_out)( xr, y, 1 ) + (*img_out)( xr, y, 2 );
+	if ( (*img_msk)( x, yb ) != 0 )
+		lb = (*img_out)( x, yb, 0 ) + (*img_out)( x, yb, 1 ) + (*img_out)( x, yb, 2 );
+	desc_out[ DESC_GRAD ].set( x, y, descGradient( l, lr, lb ) );
+}
+
+
+void Args::descriptors() {
+	/*
+	Bring the descriptor tables up to date: the patch ones
+	when it changed, the texture ones on the rects changed
+	since the last call (and the pixels on their left and
+	top, whose gradient depends on them), or in full.
+	*/
+	uint_t i, j, c, k, x, y;
+
+	if ( !desc_patch ) {
+
+		for ( c=0; c < DESC_TABLES; c++ )
+			desc_in[ c ].init( p_width, p_height );
+
+		for ( j=0; j < p_height; j++ )
+			for ( i=0; i < p_width; i++ ) {
+				int l = (*img_in)( i, j, 0 ) + (*img_in)( i, j, 1 ) + (*img_in)( i, j, 2 );
+				int lr = -1, lb = -1;
+
+				if ( i + 1 < p_width )
+					lr = (*img_in)( i + 1, j, 0 ) + (*img_in)( i + 1, j, 1 ) + (*img_in)( i + 1, j, 2 );
+				if ( j + 1 < p_height )
+					lb = (*img_in)( i, j + 1, 0 ) + (*img_in)( i, j + 1, 1 ) + (*img_in)( i, j + 1, 2 );
+				for ( c=0; c < 3; c++ )
+					desc_in[ c ].set( i, j, (*img_in)( i, j, c ) );
+				desc_in[ DESC_GRAD ].set( i, j, descGradient( l, lr, lb ) );
+			}
+		desc_patch = true;
+	}
+
+	if ( !desc_valid ) {
+
+		for ( c=0; c < DESC_TABLES; c++ )
+			desc_out[ c ].init( t_width, t_height );
+		for ( j=0; j < t_height; j++ )
+			for ( i=0; i < t_width; i++ )
+				descPixel( i, j );
+		desc_valid = true;
+	}
+	else {
+		for ( k=0; k < desc_dirty.size(); k++ ) {
+
+			uint_t w = desc_dirty[ k ].w + 1, h = desc_dirty[ k ].h + 1;
+			if ( w > t_width ) w = t_width;
+			if ( h > t_height ) h = t_height;
+
+			for ( j=0, y=( desc_dirty[ k ].y + t_height - 1 ) % t_height; j < h; j++, y=nextY( y ) )
+				for ( i=0, x=( desc_dirty[ k ].x + t_width - 1 ) % t_width; i < w; i++, x=nextX( x ) )
+					descPixel( x, y );
+		}
+	}
+	desc_dirty.clear();
+
+	/* prefix sums rebuilt now, read by several threads then */
+	for ( c=0; c < DESC_TABLES; c++ ) {
+		desc_in[ c ].total();
+		desc_out[ c ].total();
+	}
+	occupancy.total();
+}
+
+
+void Args::descDirty( uint_t x, uint_t y, uint_t w, uint_t h ) {
+	/*
+	Record that the w x h texture rect at (x,y) changed,
+	for the next update of the descriptor tables.
+	*/
+	rect_t rect;
+
+	if ( !desc_valid )
+		return;
+
+	if ( desc_dirty.size() >= MAP_MAX_DIRTY ) {
+		desc_valid = false;
+		desc_dirty.clear();
+		return;
+	}
+
+	rect.x = x % t_width;
+	rect.y = y % t_height;
+	rect.w = w;
+	rect.h = h;
+	desc_dirty.push_back( rect );
+}
+
+
+float Args::descDistance( uint_t x, uint_t y ) {
+	/*
+	Estimate of the mean SSD of the patch at offset (x,y),
+	from DESC_CELLS x DESC_CELLS cells: on each one, the
+	mean colours (the low frequencies of the window) and
+	the RMS gradient (its texture) of the pixels set are
+	compared to those of the patch, weighted by the number
+	of pixels set. Needs descriptors() first.
+	*/
+	uint_t a, b, c, n, total = 0;
+	double d = 0;
+
+	for ( b=0; b < DESC_CELLS; b++ )
+		for ( a=0; a < DESC_CELLS; a++ ) {
+
+			uint_t x0 = a * p_width / DESC_CELLS, x1 = ( a + 1 ) * p_width / DESC_CELLS;
+			uint_t y0 = b * p_height / DESC_CELLS, y1 = ( b + 1 ) * p_height / DESC_CELLS;
+			uint_t tx = ( x + x0 ) % t_width, ty = ( y + y0 ) % t_height;
+			double area = (double) ( x1 - x0 ) * ( y1 - y0 ), e;
+
+			if ( area == 0 )
+				continue;
+			n = occupancy.sum( tx, ty, x1 - x0, y1 - y0 );
+			if ( n == 0 )
+				continue;
+			total += n;
+
+			for ( c=0; c < 3; c++ ) {
+				e = desc_out[ c ].sum( tx, ty, x1 - x0, y1 - y0 ) / (double) n
+					- desc_in[ c ].sum( x0, y0, x1 - x0, y1 - y0 ) / area;
+				d += n * e * e;
+			}
+			e = sqrt( desc_out[ DESC_GRAD ].sum( tx, ty, x1 - x0, y1 - y0 ) / (double) n )
+				- sqrt( desc_in[ DESC_GRAD ].sum( x0, y0, x1 - x0, y1 - y0 ) / area );
+			d += n * e * e;
+		}
+
+	return total ? (float) ( d / total ) : 0;
+}
+
+
+void Args::descPrune( vector< candidate_t > & cand ) {
+	/*
+	Keep the prune_ratio valid candidates with the lowest
+	descriptor distance in their cost (at least one), the
+	others are made invalid; desc_kept gets the indices of
+	those kept, closest first (ties to the lowest index).
+	*/
+	vector< desc_order_t > & order = desc_order;
+	vector< int > & kept = desc_kept;
+	uint_t i, keep;
+
+	order.clear();
+	kept.clear();
+
+	for ( i=0; i < cand.size(); i++ )
+		if ( cand[ i ].valid ) {
+			desc_order_t o;
+			o.dist = cand[ i ].cost;
+			o.i = i;
+			order.push_back( o );
+		}
+
+	keep = (uint_t) ceil( order.size() * prune_ratio );
+	if ( keep < 1 )
+		keep = 1;
+	if ( keep > order.size() )
+		keep = order.size();
+
+	nth_element( order.begin(), order.begin() + keep, order.end() );
+	sort( order.begin(), order.begin() + keep );
+	for ( i=0; i < order.size(); i++ ) {
+		if ( i < keep )
+			kept.push_back( order[ i ].i );
+		else
+			cand[ order[ i ].i ].valid = false;
+	}
+}
@@ -37,6 +37,22 @@
 
 #include "args.h"
 #include "graph.h"
+#include "gridgraph.h"
+
+
+template < class C, class F >
+static typename Graph< C, F >::node_id graphPixel( Graph< C, F > * G, uint_t /* x */, uint_t /* y */ ) {
+  /*
+    Node of pixel (x,y) of the (sub)patch: Graph does not know about pixels.
+  */
+  return G->add_node();
+}
+
+
+static GridGraph::node_id graphPixel( GridGraph * G, uint_t x, uint_t y ) {
+
+  return G->add_node( x, y );
+}
 
 
 
@@ -45,48 +61,69 @@
 /*************/
 
 
-void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
+template < class GT >
+void Args::graphCreate( GT * G, const place_t & pos, vector< typename GT::node_id > & nodes,
+			edge_costs_t & costs, vector< uint_t > & labels ) {
   /*
     From a position of a new patch, creates the graph of the overlap:
     a node is a pixel, linked to its neighbors
     border pixels are linked to the Source or Sink.
-    pos[0]: X coordinate
-    pos[1]: Y coordinate
-    pos[2]: #pixels overlapping
+    pos.x: X coordinate
+    pos.y: Y coordinate
+    pos.k: #pixels overlapping
+    pos.x0, pos.x1: X limits of the (sub)patch, in the patch
+    pos.y0, pos.y1: Y limits of the (sub)patch, in the patch
+    costs: buffers for the edge costs
+    labels: node index + 1 of each pixel of the (sub)patch,
+    row by row, 0 if not overlapping ( read by graphCutSeam() )
   */
+  typedef typename GT::captype cap_t;
   uint_t i, j, k=0;
-  vector < uint_t > puf;
-  /* initialize nodes set */
+  uint_t x, y; /* (i,j) wrapped around the texture */
+  uint_t cw = pos.x1 - pos.x0; /* row length of the costs and labels */
+  /* initialize nodes set: a pixel and up to two seam nodes
+     per pixel, so that it never grows while building */
   nodes.clear();
+  nodes.reserve( 3 * cw * ( pos.y1 - pos.y0 ) );
+  labels.assign( cw * ( pos.y1 - pos.y0 ), 0 );
+
+  /* costs of all the edges between pixels, and terminal
+     links of all the pixels, at once */
+  graphCosts( pos, costs );
+  graphBorders( pos, costs );
 
   uint_t sources=0, sinks=0, nos=0;;
 
   /* for all pixels under the (sub)patch */
-  for( i=pos[0]+pos[3]; i < pos[0] + pos[4]; i++)
-    for( j=pos[1]+pos[5]; j < pos[1] + pos[6]; j++) {
+  for( i=pos.x+pos.x0, x=i % t_width; i < pos.x + pos.x1; i++, x=nextX( x ) )
+    for( j=pos.y+pos.y0, y=j % t_height; j < pos.y + pos.y1; j++, y=nextY( y ) ) {
 
       /* if there's a pixel there: OVERLAP */
-      if ( (*img_msk)( i % t_width, j % t_height ) ) {
+      if ( (*img_msk)( x, y ) ) {
 
 	/* add the node to the graph  */
-	nodes.push_back( G->add_node() );
+	nodes.push_back( graphPixel( G, i - pos.x - pos.x0, j - pos.y - pos.y0 ) );
+	/* index of the pixel node: k moves on with the seam nodes */
+	uint_t self = k;
+	/* index of the pixel in the labels and costs */
+	uint_t l = ( j - pos.y - pos.y0 ) * cw + i - pos.x - pos.x0;
 	
-	/* to keep trace of the node index, copy k+1 in img_msk,
-	   as it was already > 0, snot a problem */
-	(*img_msk)( i % t_width, j % t_height ) = k+1;
+	/* to keep trace of the node index, copy k+1 in labels
+	   (the left and top pixels were labelled before) */
+	labels[ l ] = k+1;
 
 	/* EDGES WITH THE SOURCE, SINK, OR NOTHING */
 
 	/* if node linked to SINK (close to texture border)  
 	   Criterion: boundary pixel, ie extrema coordinates 
 	*/
-	if ( borderTexture( pos, i, j ) ) {
+	if ( costs.border[ l ] == BORDER_SINK ) {
 
 	  G->set_tweights( nodes[k], 0, MAX_SHORT );
 	  sinks++;
 	}
 	/* else, if linked to SOURCE (close to an empty area) */
-	else if ( borderPatch( pos, i, j ) ) {
+	else if ( costs.border[ l ] == BORDER_SOURCE ) {
 
 	  G->set_tweights( nodes[k], MAX_SHORT, 0 );
 	  sources++;
@@ -105,19 +142,18 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 	   idem for left pixel
 	*/
 	uint_t nodex;
-	Graph::captype ncost;
-	uint_t home [2];
-	uint_t eend [2];
-	uint_t x = i % t_width;
-	uint_t y = j % t_height;
+	cap_t ncost;
+	/* patch coords */
+	uint_t u = i - pos.x;
+	uint_t v = j - pos.y;
 
 	/* LEFT NEIGHBOUR */
 	/* LEFT NEIGHBOUR */
 	/* LEFT NEIGHBOUR */
-	if ( i > pos[0]+pos[3] ) {
+	if ( i > pos.x+pos.x0 ) {
 	  
 	  /* if not empty */
-	  if ( (*img_msk)( (i-1)%t_width, y ) > 0 ) {
+	  if ( labels[ l-1 ] > 0 ) {
 
 	    /* SEAM NODE at left ? */
 	    /* SEAM NODE at left ? */
@@ -132,7 +168,7 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 	      nodes.push_back( G->add_node() );
 
 	      /* see paper for formula... (!!!) */
-	      ncost = graphCost( seah[w][1], seah[w][2], seah[w][3], seah[w][4],
+	      ncost = (cap_t) graphCost( seah[w][1], seah[w][2], seah[w][3], seah[w][4],
 				 seah[w][5], seah[w][6], seah[w][7], seah[w][8],
 				 seah[w][9], seah[w][10], seah[w][11], seah[w][12]
 				 ) + SEAM_BONUS;
@@ -141,35 +177,32 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 
 	      /* from LEFT pixel to SEAM node... */
 	      /* take node index of the neighbour */
-	      nodex = (*img_msk)( (i-1) % t_width, y ) - 1;
+	      nodex = labels[ l-1 ] - 1;
 	      /* ask for cost */
-	      ncost = graphCost( seah[w][1], seah[w][2], seah[w][3],
-				 (*img_in)(i-1,j,0), (*img_in)(i-1,j,1), (*img_in)(i-1,j,2),
+	      ncost = (cap_t) graphCost( seah[w][1], seah[w][2], seah[w][3],
+				 (*img_in)(u-1,v,0), (*img_in)(u-1,v,1), (*img_in)(u-1,v,2),
 				 seah[w][10], seah[w][11], seah[w][12],
-				 (*img_in)(i,j,0), (*img_in)(i,j,1), (*img_in)(i,j,2)
+				 (*img_in)(u,v,0), (*img_in)(u,v,1), (*img_in)(u,v,2)
 				 );
-	      /* here k is the index of the SEAM node => use k-1 for current node */
+	      /* here k is the index of the SEAM node, self the current one */
 	      G->add_edge( nodes[k], nodes[nodex], ncost, ncost ); 
 
 	      /* Link SEAM node to CURRENT pixel */
-	      ncost = graphCost( seah[w][4], seah[w][5], seah[w][6],
-				 (*img_in)(i-1,j,0), (*img_in)(i-1,j,1), (*img_in)(i-1,j,2),
+	      ncost = (cap_t) graphCost( seah[w][4], seah[w][5], seah[w][6],
+				 (*img_in)(u-1,v,0), (*img_in)(u-1,v,1), (*img_in)(u-1,v,2),
 				 seah[w][7], seah[w][8], seah[w][9],
-				 (*img_in)(i,j,0), (*img_in)(i,j,1), (*img_in)(i,j,2)
+				 (*img_in)(u,v,0), (*img_in)(u,v,1), (*img_in)(u,v,2)
 				 );
-	      G->add_edge( nodes[k], nodes[k-1], ncost, ncost ); 
+	      G->add_edge( nodes[k], nodes[self], ncost, ncost ); 
 	    }
 	    else { /* SIMPLER ! only add edge to the left neighbour */
 	    
 	      /* take node index of the neighbour */
-	      nodex = (*img_msk)( (i-1) % t_width, y ) - 1;
-	      /* initialize pixel_t values */
-	      home[0] = i; home[1] = j;
-	      eend[0] = i-1; eend[1] = j;
-	      /* ask for cost */
-	      ncost = graphCost( home, eend, pos );
+	      nodex = labels[ l-1 ] - 1;
+	      /* cost computed by graphCosts() */
+	      ncost = (cap_t) costs.left[ l ];
 	      /* add the edge with the cost found */
-	      G->add_edge( nodes[k], nodes[nodex], ncost, ncost ); 
+	      G->add_edge( nodes[self], nodes[nodex], ncost, ncost ); 
 	    }
 	  }
 	}
@@ -178,11 +211,11 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 	/* TOP NEIGHBOUR */
 	/* TOP NEIGHBOUR */
 	/* TOP NEIGHBOUR */
-	if ( j > pos[1]+pos[5] ) {
+	if ( j > pos.y+pos.y0 ) {
 	 
 
 	  /* if not empty */
-	  if ( (*img_msk)( x, (j-1) % t_height ) > 0 ) {
+	  if ( labels[ l-cw ] > 0 ) {
 
 	    /* SEAM NODE at top ? */
 	    /* SEAM NODE at top ? */
@@ -197,7 +230,7 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 	      nodes.push_back( G->add_node() );
 
 	      /* see paper for formula... (!!!) */
-	      ncost = graphCost( seav[w][1], seav[w][2], seav[w][3], seav[w][4],
+	      ncost = (cap_t) graphCost( seav[w][1], seav[w][2], seav[w][3], seav[w][4],
 				 seav[w][5], seav[w][6], seav[w][7], seav[w][8],
 				 seav[w][9], seav[w][10], seav[w][11], seav[w][12]
 				 ) + SEAM_BONUS;
@@ -206,45 +239,36 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 
 	      /* from LEFT pixel to SEAM node... */
 	      /* take node index of the neighbour */
-	      nodex = (*img_msk)( x, (j-1) % t_height ) - 1;
+	      nodex = labels[ l-cw ] - 1;
 	      /* ask for cost */
-	      ncost = graphCost( seav[w][1], seav[w][2], seav[w][3],
-				 (*img_in)(i,j-1,0), (*img_in)(i,j-1,1), (*img_in)(i,j-1,2),
+	      ncost = (cap_t) graphCost( seav[w][1], seav[w][2], seav[w][3],
+				 (*img_in)(u,v-1,0), (*img_in)(u,v-1,1), (*img_in)(u,v-1,2),
 				 seav[w][10], seav[w][11], seav[w][12],
-				 (*img_in)(i,j,0), (*img_in)(i,j,1), (*img_in)(i,j,2)
+				 (*img_in)(u,v,0), (*img_in)(u,v,1), (*img_in)(u,v,2)
 				 );
-	      /* here k is the index of the SEAM node => use k-1 for current node */
+	      /* here k is the index of the SEAM node, self the current one */
 	      G->add_edge( nodes[k], nodes[nodex], ncost, ncost ); 
 	      /* Link SEAM node to CURRENT pixel */
-	      ncost = graphCost( seav[w][4], seav[w][5], seav[w][6],
-				 (*img_in)(i,j-1,0), (*img_in)(i,j-1,1), (*img_in)(i,j-1,2),
+	      ncost = (cap_t) graphCost( seav[w][4], seav[w][5], seav[w][6],
+				 (*img_in)(u,v-1,0), (*img_in)(u,v-1,1), (*img_in)(u,v-1,2),
 				 seav[w][7], seav[w][8], seav[w][9],
-				 (*img_in)(i,j,0), (*img_in)(i,j,1), (*img_in)(i,j,2)
+				 (*img_in)(u,v,0), (*img_in)(u,v,1), (*img_in)(u,v,2)
 				 );
 	      
-	      /* add edge from SEAM node (k) to CURRENT node (k-1) */ 
-	      G->add_edge( nodes[k], nodes[k-1], ncost, ncost ); 
+	      /* add edge from SEAM node (k) to CURRENT node (self) */ 
+	      G->add_edge( nodes[k], nodes[self], ncost, ncost ); 
 	    }
 	    else {
 	      /* take node index of the neighbour */
-	      nodex = (*img_msk)( x, (j-1) % t_height ) - 1;
-	      /* initialize pixel_t values */
-	      home[0] = i; home[1] = j;
-	      eend[0] = i; eend[1] = j-1;
-	      /* ask for cost */
-	      ncost = graphCost( home, eend, pos );
+	      nodex = labels[ l-cw ] - 1;
+	      /* cost computed by graphCosts() */
+	      ncost = (cap_t) costs.top[ l ];
 	      /* add the edge with the cost found */
-	      G->add_edge( nodes[k], nodes[nodex], ncost, ncost ); 
+	      G->add_edge( nodes[self], nodes[nodex], ncost, ncost ); 
 	    }
 	  }
 
 	}
-	/* add the patch pixel */
-	puf.push_back( i - pos[0] );
-	puf.push_back( 1 - pos[1] );
-
-	/* clear pixel buffer */
-	puf.clear();
 	/* increment number of pixels */
 	k++;
       }
@@ -264,78 +288,54 @@ void Args::graphCreate( Graph * G, vector< uint_t > pos ) {
 }
 
 
-bool Args::borderPatch( vector< uint_t > pos, uint_t x, uint_t y ) {
+Graph16::flowtype Args::graphMaxFlow( Graph16 * G, int jobs ) {
   /*
-    Return true if the given pixel needs to be linked to the SOURCE,
-    that is, it's on an overlap are, just close to a non-overlap area,
-    still in the patch.
-    pos: offset of the patch
-    (x, y): pixel coords
-    R: given pixel is on an overlap area !
+    Computes max flow for the given graph, returning maxflow value.
+    A large graph is cut on 'jobs' threads, which gives the same
+    cut ( the source tree is the set of nodes the source reaches ):
+    graphCreate() adds the pixels column by column, each one
+    followed by its seam nodes, so the node ranges of the threads
+    are strips of columns of the (sub)patch.
    */
+  Graph16::flowtype flow;
 
-  int i, j;
-  for ( i=-1; i < 2; i++ )
-    for ( j=-1; j < 2; j++ ) {      
-      /* if close to an empty area (inside the patch) */
-      if ( (*img_msk)( (x+i) % t_width, (y+j) % t_height, 0 ) == 0 ) {
-	return true;
-      }
-    }
-  return false;
+  if ( ( jobs > 1 ) && ( G->get_node_num() >= PAR_NODES ) )
+    flow = G->maxflow_parallel( jobs );
+  else
+    flow = G->maxflow();
+
+  return flow;
 }
 
 
-bool Args::borderTexture( vector< uint_t > pos, uint_t x, uint_t y ) {
+GraphFloat::flowtype Args::graphMaxFlow( GraphFloat * G, int /* jobs */ ) {
   /*
-    Return true if the given pixel needs to be linked to the SINK,
-    that is, it's on the boundary of the patch, on an overlap area. 
-    pos: offset of the patch
-    (x, y): pixel coords
-    R: given pixel is on an overlap area !
+    Same, with exact costs, on one thread: float sums in another
+    order could move the cut.
    */
-  /* if on a border of the patch */
-
-  if ( x == pos[0]+pos[3] )
-    return true;
-  uint_t xx = pos[0] + pos[4] - 1 ;
-  if ( xx  > t_width ) {
-    if ( x == xx - 1 )
-      return true;
-    }
-  else if ( x == xx )
-    return true;
-
-  if ( y == pos[1]+pos[5] )
-    return true;
-  uint_t yy = pos[1] + pos[6] - 1 ;
-  if ( yy  > t_height ) {
-    if ( y == yy - 1 )
-      return true;
-    }
-  else if ( y == yy )
-    return true;
-  
-  return false;
+  return G->maxflow();
 }
 
 
-Graph::flowtype Args::graphMaxFlow( Graph * G ) {
+GridGraph::flowtype Args::graphMaxFlow( GridGraph * G, int /* jobs */ ) {
   /*
-    Computes max flow for the given graph, returning maxflow value.
+    Same, with the grid solver, on one thread.
    */
-  Graph::flowtype flow = G->maxflow();
-
-  return flow;
+  return G->maxflow();
 }
 
 
-int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
+template < class GT >
+int Args::graphCutSeam( GT * G, const place_t & pos, vector< typename GT::node_id > & nodes,
+			 const vector< uint_t > & labels ) {
   /*
     From the graph cut, select pixels to be copied (and copy to the mask!).
+    labels: node indices of the pixels, from graphCreate()
   */
   
   uint_t i, j;
+  uint_t x, y; /* real coordinates in the texture image, != patch coords */
+  uint_t cw = pos.x1 - pos.x0; /* row length of the labels */
   uint_t nodex, sources=0, sinks=0;
 
   bool lastSource = true; /* last pixel was source */
@@ -347,34 +347,46 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
     - if not, value is the node number, => if in source, copy
   */
   
-  for ( i=0; i < pos[4]-pos[3]; i++ ) {
+  costMapDirty( pos.x + pos.x0, pos.y + pos.y0, pos.x1 - pos.x0, pos.y1 - pos.y0 );
+  descDirty( pos.x + pos.x0, pos.y + pos.y0, pos.x1 - pos.x0, pos.y1 - pos.y0 );
+  validDirty( pos.x + pos.x0, pos.y + pos.y0, pos.x1 - pos.x0, pos.y1 - pos.y0 );
+
+  for ( i=0, x=(pos.x + pos.x0) % t_width; i < pos.x1-pos.x0; i++, x=nextX( x ) ) {
     
     frst_ov = true;
 
-    for ( j=0; j < pos[6]-pos[5]; j++ ) {
+    for ( j=0, y=(pos.y + pos.y0) % t_height; j < pos.y1-pos.y0; j++, y=nextY( y ) ) {
 
-      /* real coordinates in the texture image, != path coords */
-      uint_t x = (i + pos[0] + pos[3]) % t_width;
-      uint_t y = (j + pos[1] + pos[5]) % t_height;
+      /* patch coords */
+      uint_t u = i + pos.x0;
+      uint_t v = j + pos.y0;
+      /* left and top pixels, wrapped around the texture */
+      uint_t xl = ( x == 0 ) ? t_width - 1 : x - 1;
+      uint_t yt = ( y == 0 ) ? t_height - 1 : y - 1;
+      /* index of the pixel in the labels */
+      uint_t l = j * cw + i;
       
-      nodex = (*img_msk)( x, y );
+      nodex = labels[ l ];
       /* if pixel empty, copy patch there */
       if ( nodex == 0 ) { 
 
-	(*img_out)( x, y, 0 ) = (*img_in)( i, j, 0 );
-	(*img_out)( x, y, 1 ) = (*img_in)( i, j, 1 );
-	(*img_out)( x, y, 2 ) = (*img_in)( i, j, 2 );
+	(*img_out)( x, y, 0 ) = (*img_in)( u, v, 0 );
+	(*img_out)( x, y, 1 ) = (*img_in)( u, v, 1 );
+	(*img_out)( x, y, 2 ) = (*img_in)( u, v, 2 );
 	(*img_msk)( x, y ) = 255;
+	occupancy.set( x, y, 1 );
+	unfilled.fill( x, y );
+	img_src[ y * t_width + x ] = v * p_width + u;
 	nb_pixels++;
 
-	if ( nb_pixels >= total_pixels )
+	if ( unfilled.empty() )
 	  finished = true;
       }
       else {
 	
 	if ( frst_ov ) {
 	  
-	  if ( G->what_segment(nodes[ nodex-1 ] ) == Graph::SOURCE )
+	  if ( G->what_segment(nodes[ nodex-1 ] ) == GT::SOURCE )
 	    lastSource = true;
 	  else
 	    lastSource = false;
@@ -382,13 +394,14 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
 	}
 
 	/* overlap area, cp only if in SOURCE */
-	if ( G->what_segment(nodes[ nodex-1 ] ) == Graph::SOURCE ) {
+	if ( G->what_segment(nodes[ nodex-1 ] ) == GT::SOURCE ) {
 	  
 	  sources++;
 
-	  (*img_out)( x, y, 0 ) = (*img_in)( i, j, 0 );
-	  (*img_out)( x, y, 1 ) = (*img_in)( i, j, 1 );
-	  (*img_out)( x, y, 2 ) = (*img_in)( i, j, 2 );
+	  (*img_out)( x, y, 0 ) = (*img_in)( u, v, 0 );
+	  (*img_out)( x, y, 1 ) = (*img_in)( u, v, 1 );
+	  (*img_out)( x, y, 2 ) = (*img_in)( u, v, 2 );
+	  img_src[ y * t_width + x ] = v * p_width + u;
 
 	  /* if last pixel was from SINK, draw a black pixel, o/w draw white */
 	  if ( !lastSource ) {
@@ -401,45 +414,45 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
 	    /* ADD SEAM NODE ON THE TOP */
 	    seav[ x*t_height + y ][0] = 1;
 	    /* RVB of top pixel (BG)*/
-	    seav[ x*t_height + y ][1] = (*img_out)( x, y - 1, 0 );
-	    seav[ x*t_height + y ][2] = (*img_out)( x, y - 1, 1 );
-	    seav[ x*t_height + y ][3] = (*img_out)( x, y - 1, 2 );
+	    seav[ x*t_height + y ][1] = (*img_out)( x, yt, 0 );
+	    seav[ x*t_height + y ][2] = (*img_out)( x, yt, 1 );
+	    seav[ x*t_height + y ][3] = (*img_out)( x, yt, 2 );
 	    /* RVB of the top pixel (PATCH) */
-	    seav[ x*t_height + y ][4] = (*img_in)( i, j - 1, 0 );
-	    seav[ x*t_height + y ][5] = (*img_in)( i, j - 1, 1 );
-	    seav[ x*t_height + y ][6] = (*img_in)( i, j - 1, 2 );
+	    seav[ x*t_height + y ][4] = (*img_in)( u, v - 1, 0 );
+	    seav[ x*t_height + y ][5] = (*img_in)( u, v - 1, 1 );
+	    seav[ x*t_height + y ][6] = (*img_in)( u, v - 1, 2 );
 	    /* RVB of bottom pixel (BG)*/
 	    seav[ x*t_height + y ][7] = (*img_out)( x, y, 0 );
 	    seav[ x*t_height + y ][8] = (*img_out)( x, y, 1 );
 	    seav[ x*t_height + y ][9] = (*img_out)( x, y, 2 );
 	    /* RVB of the bottom pixel (PATCH) */
-	    seav[ x*t_height + y ][10] = (*img_in)( i, j, 0 );
-	    seav[ x*t_height + y ][11] = (*img_in)( i, j, 1 );
-	    seav[ x*t_height + y ][12] = (*img_in)( i, j, 2 );
+	    seav[ x*t_height + y ][10] = (*img_in)( u, v, 0 );
+	    seav[ x*t_height + y ][11] = (*img_in)( u, v, 1 );
+	    seav[ x*t_height + y ][12] = (*img_in)( u, v, 2 );
 
 	    /* Look at THE LEFT PIXEL: IF different origin, THEN add seam node */
-	    uint_t xx = (i - 1 + pos[0] + pos[3]) % t_width;
-	    uint_t yy = (j + pos[1] + pos[5]) % t_height;
-	    if ( G->what_segment( nodes[ (*img_msk)( xx, yy ) - 1 ] ) == Graph::SINK ) {
+	    /* (only if it is a node of the graph) */
+	    if ( ( i > 0 ) && ( labels[ l-1 ] > 0 )
+		 && ( G->what_segment( nodes[ labels[ l-1 ] - 1 ] ) == GT::SINK ) ) {
 	      
 	      /* ADD SEAM NODE ON THE LEFT */
 	      seah[ x*t_height + y ][0] = 1;
 	      /* RVB of left pixel (BG)*/
-	      seah[ x*t_height + y ][1] = (*img_out)( x-1, y, 0 );
-	      seah[ x*t_height + y ][2] = (*img_out)( x-1, y, 1 );
-	      seah[ x*t_height + y ][3] = (*img_out)( x-1, y, 2 );
+	      seah[ x*t_height + y ][1] = (*img_out)( xl, y, 0 );
+	      seah[ x*t_height + y ][2] = (*img_out)( xl, y, 1 );
+	      seah[ x*t_height + y ][3] = (*img_out)( xl, y, 2 );
 	      /* RVB of the left pixel (PATCH) */
-	      seah[ x*t_height + y ][4] = (*img_in)( i-1, j, 0 );
-	      seah[ x*t_height + y ][5] = (*img_in)( i-1, j, 1 );
-	      seah[ x*t_height + y ][6] = (*img_in)( i-1, j, 2 );
+	      seah[ x*t_height + y ][4] = (*img_in)( u-1, v, 0 );
+	      seah[ x*t_height + y ][5] = (*img_in)( u-1, v, 1 );
+	      seah[ x*t_height + y ][6] = (*img_in)( u-1, v, 2 );
 	      /* RVB of right pixel (BG)*/
 	      seah[ x*t_height + y ][7] = (*img_out)( x, y, 0 );
 	      seah[ x*t_height + y ][8] = (*img_out)( x, y, 1 );
 	      seah[ x*t_height + y ][9] = (*img_out)( x, y, 2 );
 	      /* RVB of the right pixel (PATCH) */
-	      seah[ x*t_height + y ][10] = (*img_in)( i, j, 0 );
-	      seah[ x*t_height + y ][11] = (*img_in)( i, j, 1 );
-	      seah[ x*t_height + y ][12] = (*img_in)( i, j, 2 );
+	      seah[ x*t_height + y ][10] = (*img_in)( u, v, 0 );
+	      seah[ x*t_height + y ][11] = (*img_in)( u, v, 1 );
+	      seah[ x*t_height + y ][12] = (*img_in)( u, v, 2 );
 	    }
 
 	  }
@@ -447,7 +460,7 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
 	    (*img_err)( x, y ) = 255;
 	}
 	/* superposition => do not nb_pixels++ */
-	else  if ( G->what_segment(nodes[ nodex-1 ] ) == Graph::SINK ){
+	else  if ( G->what_segment(nodes[ nodex-1 ] ) == GT::SINK ){
 	  /* SINK: DO NOT COPY ANYTHING */
 	  sinks++;
 
@@ -462,42 +475,42 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
 	    /* ADD SEAM NODE ON THE TOP */
 	    seav[ x*t_height + y ][0] = 1;
 	    /* RVB of top pixel (in PATCH)*/
-	    seav[ x*t_height + y ][1] = (*img_in)( i, j-1, 0 );
-	    seav[ x*t_height + y ][2] = (*img_in)( i, j-1, 1 );
-	    seav[ x*t_height + y ][3] = (*img_in)( i, j-1, 2 );
+	    seav[ x*t_height + y ][1] = (*img_in)( u, v-1, 0 );
+	    seav[ x*t_height + y ][2] = (*img_in)( u, v-1, 1 );
+	    seav[ x*t_height + y ][3] = (*img_in)( u, v-1, 2 );
 	    /* RVB of top pixel (in BG)*/
-	    seav[ x*t_height + y ][4] = (*img_out)( x, y-1, 0 );
-	    seav[ x*t_height + y ][5] = (*img_out)( x, y-1, 1 );
-	    seav[ x*t_height + y ][6] = (*img_out)( x, y-1, 2 );
+	    seav[ x*t_height + y ][4] = (*img_out)( x, yt, 0 );
+	    seav[ x*t_height + y ][5] = (*img_out)( x, yt, 1 );
+	    seav[ x*t_height + y ][6] = (*img_out)( x, yt, 2 );
 	    /* RVB of the bottom pixel (in PATCH) */
-	    seav[ x*t_height + y ][7] = (*img_in)( i, j, 0);
-	    seav[ x*t_height + y ][8] = (*img_in)( i, j, 1);
-	    seav[ x*t_height + y ][9] = (*img_in)( i, j, 2);
+	    seav[ x*t_height + y ][7] = (*img_in)( u, v, 0);
+	    seav[ x*t_height + y ][8] = (*img_in)( u, v, 1);
+	    seav[ x*t_height + y ][9] = (*img_in)( u, v, 2);
 	    /* RVB of the bottom pixel (in BG) */
 	    seav[ x*t_height + y ][10] = (*img_out)( x, y, 0 );
 	    seav[ x*t_height + y ][11] = (*img_out)( x, y, 1 );
 	    seav[ x*t_height + y ][12] = (*img_out)( x, y, 2 );
 
 	    /* Look at THE LEFT PIXEL: IF different origin, THEN add seam node */
-	    uint_t xx = (i - 1 + pos[0] + pos[3]) % t_width;
-	    uint_t yy = (j + pos[1] + pos[5]) % t_height;
-	    if ( G->what_segment( nodes[ (*img_msk)( xx, yy ) - 1 ] ) == Graph::SOURCE ) {
+	    /* (only if it is a node of the graph) */
+	    if ( ( i > 0 ) && ( labels[ l-1 ] > 0 )
+		 && ( G->what_segment( nodes[ labels[ l-1 ] - 1 ] ) == GT::SOURCE ) ) {
 	      
 	      /* ADD SEAM NODE ON THE LEFT */
 	      seah[ x*t_height + y ][0] = 1;
 
 	      /* RVB of left pixel (in PATCH)*/
-	      seah[ x*t_height + y ][1] = (*img_in)( i-1, j, 0 );
-	      seah[ x*t_height + y ][2] = (*img_in)( i-1, j, 1 );
-	      seah[ x*t_height + y ][3] = (*img_in)( i-1, j, 2 );
+	      seah[ x*t_height + y ][1] = (*img_in)( u-1, v, 0 );
+	      seah[ x*t_height + y ][2] = (*img_in)( u-1, v, 1 );
+	      seah[ x*t_height + y ][3] = (*img_in)( u-1, v, 2 );
 	      /* RVB of left pixel (in BG)*/
-	      seah[ x*t_height + y ][4] = (*img_out)( x-1, y, 0 );
-	      seah[ x*t_height + y ][5] = (*img_out)( x-1, y, 1 );
-	      seah[ x*t_height + y ][6] = (*img_out)( x-1, y, 2 );
+	      seah[ x*t_height + y ][4] = (*img_out)( xl, y, 0 );
+	      seah[ x*t_height + y ][5] = (*img_out)( xl, y, 1 );
+	      seah[ x*t_height + y ][6] = (*img_out)( xl, y, 2 );
 	      /* RVB of the right pixel (in PATCH) */
-	      seah[ x*t_height + y ][7] = (*img_in)( i, j, 0);
-	      seah[ x*t_height + y ][8] = (*img_in)( i, j, 1);
-	      seah[ x*t_height + y ][9] = (*img_in)( i, j, 2);
+	      seah[ x*t_height + y ][7] = (*img_in)( u, v, 0);
+	      seah[ x*t_height + y ][8] = (*img_in)( u, v, 1);
+	      seah[ x*t_height + y ][9] = (*img_in)( u, v, 2);
 	      /* RVB of the right pixel (in BG) */
 	      seah[ x*t_height + y ][10] = (*img_out)( x, y, 0 );
 	      seah[ x*t_height + y ][11] = (*img_out)( x, y, 1 );
@@ -516,7 +529,170 @@ int Args::graphCutSeam( Graph * G, vector< uint_t > pos ) {
 
 
 
-Graph::captype Args::graphCost( uint_t * s, uint_t * t, vector< uint_t > offset ) {
+void Args::graphCosts( const place_t & pos, edge_costs_t & costs ) {
+  /*
+    Costs of all the edges between neighbour pixels of the (sub)patch,
+    as graphCost() gives them: costs.left[ v*w + u ] links (u,v) to
+    (u-1,v) (u > 0), costs.top[ v*w + u ] links it to (u,v-1) (v > 0),
+    in (sub)patch coordinates.
+    The texture under the (sub)patch is first copied row by row
+    (a wrapping row in two parts), so that the loops below only read
+    contiguous rows, without modulo, and can be vectorized by the compiler.
+    Values are also computed where pixels are empty, they are just not used.
+  */
+  uint_t w = pos.x1 - pos.x0;
+  uint_t h = pos.y1 - pos.y0;
+  uint_t n = w * h;
+  uint_t x0 = ( pos.x + pos.x0 ) % t_width;
+  uint_t head = min( w, t_width - x0 ); /* pixels before wrapping */
+  uint_t u, v, y;
+  int c;
+  bool exact = ( cost_reduction == 0 ); /* costs not rounded ( -C 0 ) */
+
+  costs.tex.resize( 3 * n );
+  costs.left.resize( n );
+  costs.top.resize( n );
+
+  for ( c=0; c < 3; c++ )
+    for ( v=0; v < h; v++ ) {
+      y = ( pos.y + pos.y0 + v ) % t_height;
+      uchar_t * row = &costs.tex[ c*n + v*w ];
+      memcpy( row, img_out->ptr( x0, y, 0, c ), head );
+      if ( head < w )
+	memcpy( row + head, img_out->ptr( 0, y, 0, c ), w - head );
+    }
+
+  /* differences texture - patch */
+  for ( v=0; v < h; v++ ) {
+
+    const uchar_t * t[3], * p[3];
+    cost_t * left = &costs.left[ v*w ];
+
+    for ( c=0; c < 3; c++ ) {
+      t[c] = &costs.tex[ c*n + v*w ];
+      p[c] = img_in->ptr( pos.x0, pos.y0 + v, 0, c );
+    }
+
+    /* LEFT edges */
+    if ( cost_fx == C1 ) {
+      for ( u=1; u < w; u++ ) {
+	int m = abs( t[0][u] - p[0][u] ) + abs( t[0][u-1] - p[0][u-1] )
+	  + abs( t[1][u] - p[1][u] ) + abs( t[1][u-1] - p[1][u-1] )
+	  + abs( t[2][u] - p[2][u] ) + abs( t[2][u-1] - p[2][u-1] );
+	left[u] = exact ? m / 3.0f : (cost_t) ( ( m / 3 ) / cost_reduction );
+      }
+    }
+    else {
+      for ( u=1; u < w; u++ ) {
+	int m = abs( t[0][u] - p[0][u] ) + abs( t[0][u-1] - p[0][u-1] )
+	  + abs( t[1][u] - p[1][u] ) + abs( t[1][u-1] - p[1][u-1] )
+	  + abs( t[2][u] - p[2][u] ) + abs( t[2][u-1] - p[2][u-1] );
+	int g = ( abs( t[0][u] - t[0][u-1] ) + abs( t[1][u] - t[1][u-1] )
+		  + abs( t[2][u] - t[2][u-1] ) ) / 3
+	  + ( abs( p[0][u] - p[0][u-1] ) + abs( p[1][u] - p[1][u-1] )
+	      + abs( p[2][u] - p[2][u-1] ) ) / 3;
+	left[u] = exact ? ( m / 3.0f ) / grad_sqrt[ g+1 ]
+	  : (cost_t) (int) ( ( m / 3 ) / grad_sqrt[ g+1 ] );
+      }
+    }
+
+    if ( v == 0 )
+      continue;
+
+    /* TOP edges, with the previous row */
+    const uchar_t * ta[3], * pa[3];
+    cost_t * top = &costs.top[ v*w ];
+
+    for ( c=0; c < 3; c++ ) {
+      ta[c] = t[c] - w;
+      pa[c] = img_in->ptr( pos.x0, pos.y0 + v - 1, 0, c );
+    }
+
+    if ( cost_fx == C1 ) {
+      for ( u=0; u < w; u++ ) {
+	int m = abs( t[0][u] - p[0][u] ) + abs( ta[0][u] - pa[0][u] )
+	  + abs( t[1][u] - p[1][u] ) + abs( ta[1][u] - pa[1][u] )
+	  + abs( t[2][u] - p[2][u] ) + abs( ta[2][u] - pa[2][u] );
+	top[u] = exact ? m / 3.0f : (cost_t) ( ( m / 3 ) / cost_reduction );
+      }
+    }
+    else {
+      for ( u=0; u < w; u++ ) {
+	int m = abs( t[0][u] - p[0][u] ) + abs( ta[0][u] - pa[0][u] )
+	  + abs( t[1][u] - p[1][u] ) + abs( ta[1][u] - pa[1][u] )
+	  + abs( t[2][u] - p[2][u] ) + abs( ta[2][u] - pa[2][u] );
+	int g = ( abs( t[0][u] - ta[0][u] ) + abs( t[1][u] - ta[1][u] )
+		  + abs( t[2][u] - ta[2][u] ) ) / 3
+	  + ( abs( p[0][u] - pa[0][u] ) + abs( p[1][u] - pa[1][u] )
+	      + abs( p[2][u] - pa[2][u] ) ) / 3;
+	top[u] = exact ? ( m / 3.0f ) / grad_sqrt[ g+1 ]
+	  : (cost_t) (int) ( ( m / 3 ) / grad_sqrt[ g+1 ] );
+      }
+    }
+  }
+}
+
+
+void Args::graphBorders( const place_t & pos, edge_costs_t & costs ) {
+  /*
+    Terminal link of each pixel of the (sub)patch, row by row:
+    costs.border is BORDER_SINK on the border of the (sub)patch
+    ( the old texture around it is kept ), else BORDER_SOURCE
+    when one of its 8 neighbours is empty ( the patch fills the
+    hole ), else BORDER_NONE ( only read for the pixels set ).
+    Inside the (sub)patch, the 3x3 neighbours of a pixel are in
+    the (sub)patch too: the mask under it is copied, then eroded
+    by a row pass and a column pass, without modulo.
+  */
+  uint_t w = pos.x1 - pos.x0;
+  uint_t h = pos.y1 - pos.y0;
+  uint_t n = w * h;
+  uint_t x0 = ( pos.x + pos.x0 ) % t_width;
+  uint_t head = min( w, t_width - x0 ); /* pixels before wrapping */
+  uint_t u, v, y;
+
+  costs.msk.resize( n );
+  costs.border.resize( n );
+
+  uchar_t * msk = &costs.msk[0];
+  uchar_t * row = &costs.border[0];
+
+  for ( v=0; v < h; v++ ) {
+    y = ( pos.y + pos.y0 + v ) % t_height;
+    memcpy( msk + v*w, img_msk->ptr( x0, y ), head );
+    if ( head < w )
+      memcpy( msk + v*w + head, img_msk->ptr( 0, y ), w - head );
+  }
+
+  /* all the pixels on the border */
+  memset( row, BORDER_SINK, n );
+  if ( ( w < 3 ) || ( h < 3 ) )
+    return;
+
+  /* row pass: pixel and its left and right neighbours set,
+     kept in border for now */
+  for ( v=0; v < h; v++ )
+    for ( u=1; u < w-1; u++ )
+      row[ v*w + u ] = msk[ v*w + u-1 ] & msk[ v*w + u ] & msk[ v*w + u+1 ];
+
+  /* column pass, back in msk: all the 3x3 neighbours set */
+  for ( v=1; v < h-1; v++ )
+    for ( u=1; u < w-1; u++ )
+      msk[ v*w + u ] = row[ (v-1)*w + u ] & row[ v*w + u ] & row[ (v+1)*w + u ];
+
+  for ( v=1; v < h-1; v++ ) {
+    row = &costs.border[ v*w ];
+    row[0] = row[w-1] = BORDER_SINK;
+    for ( u=1; u < w-1; u++ )
+      row[u] = msk[ v*w + u ] ? BORDER_NONE : BORDER_SOURCE;
+  }
+  /* first and last rows */
+  memset( &costs.border[0], BORDER_SINK, w );
+  memset( &costs.border[ (h-1)*w ], BORDER_SINK, w );
+}
+
+
+Args::cost_t Args::graphCost( uint_t * s, uint_t * t, const place_t & offset ) {
   /*
     Graph cost function.
   */
@@ -526,15 +702,15 @@ Graph::captype Args::graphCost( uint_t * s, uint_t * t, vector< uint_t > offset
 }
 
 
-Graph::captype Args::graphCostBasic( uint_t * s, uint_t * t, vector< uint_t > offset, int reduction ) {
+Args::cost_t Args::graphCostBasic( uint_t * s, uint_t * t, const place_t & offset, int reduction ) {
   /*
     Simplest matching quality cost function.
     M(s,t,A,D) = |A(s)-B(s)| + |A(t)-B(t)|
     ( A is the current texture, B is the patch )
     We assume that s and t are pixels overlapping,
     when patch placed at the given offset. 
-    offset[0] = patch's top-left corner's X
-    offset[1] = patch's top-left corner's Y
+    offset.x = patch's top-left corner's X
+    offset.y = patch's top-left corner's Y
    
     The returned value is the mean on each channel (RVB).
   */
@@ -543,10 +719,10 @@ Graph::captype Args::graphCostBasic( uint_t * s, uint_t * t, vector< uint_t > of
   uint_t ys = s[1] % t_height;
   uint_t xt = t[0] % t_width;
   uint_t yt = t[1] % t_height;
-  uint_t xsi = s[0] - offset[0];
-  uint_t ysi = s[1] - offset[1];
-  uint_t xti = t[0] - offset[0];
-  uint_t yti = t[1] - offset[1];
+  uint_t xsi = s[0] - offset.x;
+  uint_t ysi = s[1] - offset.y;
+  uint_t xti = t[0] - offset.x;
+  uint_t yti = t[1] - offset.y;
 
   cr = abs( (*img_out)( xs, ys, 0 ) - (*img_in)( xsi, ysi, 0 ) )
     +  abs( (*img_out)( xt, yt, 0 ) - (*img_in)( xti, yti, 0 ) );
@@ -555,13 +731,16 @@ Graph::captype Args::graphCostBasic( uint_t * s, uint_t * t, vector< uint_t > of
   cb = abs( (*img_out)( xs, ys, 2 ) - (*img_in)( xsi, ysi, 2 ) )
     +  abs( (*img_out)( xt, yt, 2 ) - (*img_in)( xti, yti, 2 ) );
 
+  if ( reduction == 0 ) /* exact costs */
+    return ( cr + cv + cb ) / 3.0f;
+
   cost = (uint_t) ( ( cr + cv + cb ) / 3 );
 
-  return (Graph::captype) cost / reduction;
+  return (cost_t) ( cost / reduction );
 }
 
 
-Graph::captype Args::graphCostGradi( uint_t * s, uint_t * t, vector< uint_t > offset ){
+Args::cost_t Args::graphCostGradi( uint_t * s, uint_t * t, const place_t & offset ){
   /*
     Matching cost function using gradient of the pixels.
     Each gradient is the mean of the gradients off each channel.
@@ -577,10 +756,10 @@ Graph::captype Args::graphCostGradi( uint_t * s, uint_t * t, vector< uint_t > of
   gradTextV  = abs( (*img_out)( xs, ys, 1 ) - (*img_out)( xt, yt, 1 ) );
   gradTextB  = abs( (*img_out)( xs, ys, 2 ) - (*img_out)( xt, yt, 2 ) );
 
-  xs = s[0] - offset[0];
-  ys = s[1] - offset[1];
-  xt = t[0] - offset[0];
-  yt = t[1] - offset[1];
+  xs = s[0] - offset.x;
+  ys = s[1] - offset.y;
+  xt = t[0] - offset.x;
+  yt = t[1] - offset.y;
 
   gradPatchR  = abs( (*img_in)( xs, ys, 0 ) - (*img_in)( xt, yt, 0 ) );
   gradPatchV  = abs( (*img_in)( xs, ys, 1 ) - (*img_in)( xt, yt, 1 ) );
@@ -591,11 +770,14 @@ Graph::captype Args::graphCostGradi( uint_t * s, uint_t * t, vector< uint_t > of
 
   grad++; /* to avoid zero division */
 
-  return (Graph::captype) ( graphCostBasic( s, t, offset, 1 ) / sqrt((float)grad) );
+  if ( cost_reduction == 0 ) /* exact costs */
+    return graphCostBasic( s, t, offset, 0 ) / sqrt((float)grad);
+
+  return (cost_t) (int) ( graphCostBasic( s, t, offset, 1 ) / sqrt((float)grad) );
 }
 
 
-Graph::captype Args::graphCost( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+Args::cost_t Args::graphCost( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 				uchar_t s2r, uchar_t s2v, uchar_t s2b,
 				uchar_t t1r, uchar_t t1v, uchar_t t1b,
 				uchar_t t2r, uchar_t t2v, uchar_t t2b
@@ -611,7 +793,7 @@ Graph::captype Args::graphCost( uchar_t s1r, uchar_t s1v, uchar_t s1b,
 }
 
 
-Graph::captype Args::graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+Args::cost_t Args::graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 				     uchar_t s2r, uchar_t s2v, uchar_t s2b,
 				     uchar_t t1r, uchar_t t1v, uchar_t t1b,
 				     uchar_t t2r, uchar_t t2v, uchar_t t2b,
@@ -623,8 +805,8 @@ Graph::captype Args::graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b,
     ( A is the current texture, B is the patch )
     We assume that s and t are pixels overlapping,
     when patch placed at the given offset. 
-    offset[0] = patch's top-left corner's X
-    offset[1] = patch's top-left corner's Y
+    offset.x = patch's top-left corner's X
+    offset.y = patch's top-left corner's Y
    
     The returned value is the mean on each channel (RVB).
   */
@@ -634,13 +816,16 @@ Graph::captype Args::graphCostBasic( uchar_t s1r, uchar_t s1v, uchar_t s1b,
   cv = abs( s1v - s2v ) +  abs( t1v - t2v );
   cb = abs( s1b - s2b ) +  abs( t1b - t2b );
 
+  if ( reduction == 0 ) /* exact costs */
+    return ( cr + cv + cb ) / 3.0f;
+
   cost = (uint_t) ( ( cr + cv + cb ) / 3 );
 
-  return (Graph::captype) cost / reduction;
+  return (cost_t) ( cost / reduction );
 }
 
 
-Graph::captype Args::graphCostGradi( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
+Args::cost_t Args::graphCostGradi( uchar_t s1r, uchar_t s1v, uchar_t s1b, 
 				     uchar_t s2r, uchar_t s2v, uchar_t s2b,
 				     uchar_t t1r, uchar_t t1v, uchar_t t1b,
 				     uchar_t t2r, uchar_t t2v, uchar_t t2b
@@ -665,6 +850,25 @@ Graph::captype Args::graphCostGradi( uchar_t s1r, uchar_t s1v, uchar_t s1b,
 
   grad++; /* to avoid zero division */
 
-  return (Graph::captype) ( graphCostBasic( s1r, s1v, s1b, s2r, s2v, s2b,
-					    t1r, t1v, t1b, t2r, t2v, t2b, 1 ) / sqrt((float)grad) );
+  if ( cost_reduction == 0 ) /* exact costs */
+    return graphCostBasic( s1r, s1v, s1b, s2r, s2v, s2b,
+			   t1r, t1v, t1b, t2r, t2v, t2b, 0 ) / sqrt((float)grad);
+
+  return (cost_t) (int) ( graphCostBasic( s1r, s1v, s1b, s2r, s2v, s2b,
+					  t1r, t1v, t1b, t2r, t2v, t2b, 1 ) / sqrt((float)grad) );
 }
+
+
+/* the two solvers, Graph with both capacities */
+template void Args::graphCreate( Graph16 * G, const place_t & pos, vector< Graph16::node_id > & nodes,
+				 edge_costs_t & costs, vector< uint_t > & labels );
+template void Args::graphCreate( GraphFloat * G, const place_t & pos, vector< GraphFloat::node_id > & nodes,
+				 edge_costs_t & costs, vector< uint_t > & labels );
+template void Args::graphCreate( GridGraph * G, const place_t & pos, vector< GridGraph::node_id > & nodes,
+				 edge_costs_t & costs, vector< uint_t > & labels );
+template int Args::graphCutSeam( Graph16 * G, const place_t & pos, vector< Graph16::node_id > & nodes,
+				 const vector< uint_t > & labels );
+template int Args::graphCutSeam( GraphFloat * G, const place_t & pos, vector< GraphFloat::node_id > & nodes,
+				 const vector< uint_t > & labels );
+template int Args::graphCutSeam( GridGraph * G, const place_t & pos, vector< GridGraph::node_id > & nodes,
+				 const vector< uint_t > & labels );
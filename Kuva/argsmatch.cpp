@@ -0,0 +1,489 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* argsmatch.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "args.h"
+
+
+
+/************/
+/* COST MAP */
+/************/
+
+
+void Args::patchSpectra( FFT2D & f, vector< cplx_t > * spec ) {
+	/*
+	Conjugated spectra of the patch terms (window, sum of
+	squares, red, green, blue), the patch being put at the
+	origin of an image of the size of f.
+	*/
+	uint_t i, j, c;
+	uint_t fw = f.getWidth(), fh = f.getHeight(), n = fw * fh;
+	uint_t w = ( p_width < fw ) ? p_width : fw;
+	uint_t h = ( p_height < fh ) ? p_height : fh;
+	vector< cplx_t > z( n );
+
+	for ( c=0; c < 5; c++ )
+		spec[ c ].resize( n );
+
+	/* window + i.(sum of squares) */
+	for ( j=0; j < h; j++ )
+		for ( i=0; i < w; i++ ) {
+			double sq = 0;
+			for ( c=0; c < 3; c++ )
+				sq += squares[ (*img_in)( i, j, c ) ];
+			z[ j * fw + i ] = cplx_t( 1, sq );
+		}
+	f.forward2( &z[0], &spec[ SPEC_WIN ][0], &spec[ SPEC_SQ ][0] );
+
+	/* red + i.green */
+	z.assign( n, 0 );
+	for ( j=0; j < h; j++ )
+		for ( i=0; i < w; i++ )
+			z[ j * fw + i ] = cplx_t( (*img_in)( i, j, 0 ), (*img_in)( i, j, 1 ) );
+	f.forward2( &z[0], &spec[ SPEC_RED ][0], &spec[ SPEC_GREEN ][0] );
+
+	/* blue */
+	z.assign( n, 0 );
+	for ( j=0; j < h; j++ )
+		for ( i=0; i < w; i++ )
+			z[ j * fw + i ] = (*img_in)( i, j, 2 );
+	f.forward( &z[0] );
+	spec[ SPEC_BLUE ] = z;
+
+	for ( c=0; c < 5; c++ )
+		for ( i=0; i < n; i++ )
+			spec[ c ][ i ] = conj( spec[ c ][ i ] );
+}
+
+
+void Args::textureTerms( uint_t part, cplx_t * z, uint_t fw, uint_t fh,
+						uint_t x0, uint_t y0, uint_t u0, uint_t v0,
+						uint_t w, uint_t h, bool delta ) {
+	/*
+	Fill the fw x fh image z with zeros, but for the w x h
+	texture rect at (x0,y0), put at (u0,v0), where it holds
+	the texture terms:
+	part 0: mask + i.(mask * sum of squares)
+	part 1: masked red + i.(masked green)
+	part 2: masked blue
+	With delta, the terms of map_out (the texture the maps
+	were computed on) are subtracted.
+	*/
+	uint_t i, j, c, x, y;
+	double t[5], o[5];
+
+	for ( i=0; i < fw * fh; i++ )
+		z[ i ] = 0;
+
+	for ( j=0, y=y0 % t_height; j < h; j++, y=nextY( y ) )
+		for ( i=0, x=x0 % t_width; i < w; i++, x=nextX( x ) ) {
+
+			t[0] = t[1] = t[2] = t[3] = t[4] = 0;
+			if ( (*img_msk)( x, y ) != 0 ) {
+				t[0] = 1;
+				for ( c=0; c < 3; c++ ) {
+					t[1] += squares[ (*img_out)( x, y, c ) ];
+					t[ 2 + c ] = (*img_out)( x, y, c );
+				}
+			}
+
+			if ( delta && map_out( x, y, 0, 3 ) ) {
+				o[0] = 1;
+				o[1] = 0;
+				for ( c=0; c < 3; c++ ) {
+					o[1] += squares[ map_out( x, y, 0, c ) ];
+					o[ 2 + c ] = map_out( x, y, 0, c );
+				}
+				for ( c=0; c < 5; c++ )
+					t[ c ] -= o[ c ];
+			}
+
+			if ( part == 0 )
+				z[ ( v0 + j ) * fw + u0 + i ] = cplx_t( t[0], t[1] );
+			else if ( part == 1 )
+				z[ ( v0 + j ) * fw + u0 + i ] = cplx_t( t[2], t[3] );
+			else
+				z[ ( v0 + j ) * fw + u0 + i ] = t[4];
+		}
+}
+
+
+void Args::correlate( FFT2D & f, vector< cplx_t > * spec,
+					 uint_t x0, uint_t y0, uint_t u0, uint_t v0,
+					 uint_t w, uint_t h, bool delta ) {
+	/*
+	Correlate the texture terms of a rect (see textureTerms)
+	with the patch spectra spec, for every offset of an image
+	of the size of f. On output spec_tex[3] holds SSD + i.count:
+	with M the mask, O the texture, P the patch and W the
+	patch window, the masked SSD expands in three correlations
+	SSD(x,y) = sum W.M.O^2 - 2 sum P.M.O + sum P^2.M
+	and the overlap count is sum W.M.
+	*/
+	uint_t i, fw = f.getWidth(), fh = f.getHeight(), n = fw * fh;
+	cplx_t * z, * a, * b, * acc;
+
+	z = &spec_tex[0][0];
+	a = &spec_tex[1][0];
+	b = &spec_tex[2][0];
+	acc = &spec_tex[3][0];
+
+	/* mask + i.(mask * sum of squares) */
+	textureTerms( 0, z, fw, fh, x0, y0, u0, v0, w, h, delta );
+	f.forward2( z, a, b );
+	for ( i=0; i < n; i++ )
+		acc[ i ] = spec[ SPEC_WIN ][ i ] * b[ i ] + spec[ SPEC_SQ ][ i ] * a[ i ]
+			+ cplx_t( 0, 1 ) * spec[ SPEC_WIN ][ i ] * a[ i ];
+
+	/* masked red + i.(masked green) */
+	textureTerms( 1, z, fw, fh, x0, y0, u0, v0, w, h, delta );
+	f.forward2( z, a, b );
+	for ( i=0; i < n; i++ )
+		acc[ i ] -= 2.0 * ( spec[ SPEC_RED ][ i ] * a[ i ] + spec[ SPEC_GREEN ][ i ] * b[ i ] );
+
+	/* masked blue */
+	textureTerms( 2, z, fw, fh, x0, y0, u0, v0, w, h, delta );
+	f.forward( z );
+	for ( i=0; i < n; i++ )
+		acc[ i ] -= 2.0 * spec[ SPEC_BLUE ][ i ] * z[ i ];
+
+	/* back to the offsets domain */
+	f.inverse( acc );
+}
+
+
+void Args::costMap() {
+	/*
+	Compute, for every toroidal offset (x,y) of the patch,
+	the SSD between the patch and the texture pixels already
+	set (cost_map), and the number of such pixels (count_map),
+	in the frequency domain: O(N log N) for N offsets.
+
+	The maps are kept from one call to the next: when the
+	patch did not change, only the offsets whose window meets
+	a rect changed since (see costMapDirty) are updated, by
+	correlating the changes of the texture with the patch on
+	a (2.p_width-1) x (2.p_height-1) image, so that the work
+	depends on the area changed, not on the texture size.
+	*/
+	uint_t i, j, c, r, x, y;
+	uint_t n = t_width * t_height;
+	uint_t lw = 2 * p_width - 1, lh = 2 * p_height - 1;
+	cplx_t * acc;
+	bool full;
+
+	if ( ( fft.getWidth() != t_width ) || ( fft.getHeight() != t_height ) ) {
+
+		fft.init( t_width, t_height );
+		for ( c=0; c < 4; c++ )
+			spec_tex[ c ].resize( n );
+		cost_map.resize( n );
+		count_map.resize( n );
+		map_out = cimg_library::CImg< uchar_t >( t_width, t_height, 1, 4 );
+		fft_patch = false;
+	}
+
+	/* patch spectra, only when the patch changed */
+	if ( !fft_patch ) {
+
+		patchSpectra( fft, spec_patch );
+		fft_patch = true;
+		fft_local_patch = false;
+		map_valid = false;
+	}
+
+	/* local updates are possible if the offsets updated do not
+	wrap onto themselves, and if the rects are not larger than
+	the patch */
+	full = !map_valid || ( map_updates + map_dirty.size() > MAP_REFRESH )
+		|| ( lw > t_width ) || ( lh > t_height );
+	for ( r=0; !full && r < map_dirty.size(); r++ ) {
+		if ( ( map_dirty[ r ].w > p_width ) || ( map_dirty[ r ].h > p_height ) )
+			full = true;
+	}
+
+	if ( full ) {
+
+		correlate( fft, spec_patch, 0, 0, 0, 0, t_width, t_height, false );
+
+		acc = &spec_tex[3][0];
+		for ( i=0; i < n; i++ ) {
+			cost_map[ i ] = ( acc[ i ].real() > 0 ) ? acc[ i ].real() : 0;
+			count_map[ i ] = ( acc[ i ].imag() > 0 ) ? (uint_t) ( acc[ i ].imag() + 0.5 ) : 0;
+		}
+		map_updates = 0;
+		map_valid = true;
+		map_dirty.clear();
+		map_dirty.push_back( rect_t() );
+		map_dirty[ 0 ].w = t_width;
+		map_dirty[ 0 ].h = t_height;
+	}
+	else {
+
+		if ( ( fft_local.getWidth() != lw ) || ( fft_local.getHeight() != lh ) ) {
+			fft_local.init( lw, lh );
+			fft_local_patch = false;
+		}
+		if ( !fft_local_patch ) {
+			patchSpectra( fft_local, spec_local );
+			fft_local_patch = true;
+		}
+
+		for ( r=0; r < map_dirty.size(); r++ ) {
+
+			uint_t x0 = map_dirty[ r ].x, y0 = map_dirty[ r ].y;
+			uint_t w = map_dirty[ r ].w, h = map_dirty[ r ].h;
+
+			/* the rect is put at (p_width-1,p_height-1): local offset
+			(0,0) is the texture offset of a patch ending on its corner */
+			correlate( fft_local, spec_local, x0, y0, p_width - 1, p_height - 1, w, h, true );
+
+			acc = &spec_tex[3][0];
+			for ( j=0, y=( y0 + t_height - p_height + 1 ) % t_height;
+				  j < h + p_height - 1; j++, y=nextY( y ) )
+				for ( i=0, x=( x0 + t_width - p_width + 1 ) % t_width;
+					  i < w + p_width - 1; i++, x=nextX( x ) ) {
+
+					uint_t o = y * t_width + x;
+					cplx_t d = acc[ j * lw + i ];
+					int k = (int) count_map[ o ] + (int) floor( d.imag() + 0.5 );
+
+					count_map[ o ] = ( k > 0 ) ? k : 0;
+					cost_map[ o ] += d.real();
+					if ( ( cost_map[ o ] < 0 ) || ( count_map[ o ] == 0 ) )
+						cost_map[ o ] = 0;
+				}
+		}
+		map_updates += map_dirty.size();
+	}
+
+	/* the maps now match the texture */
+	for ( r=0; r < map_dirty.size(); r++ )
+		for ( j=0, y=map_dirty[ r ].y; j < map_dirty[ r ].h; j++, y=nextY( y ) )
+			for ( i=0, x=map_dirty[ r ].x; i < map_dirty[ r ].w; i++, x=nextX( x ) ) {
+
+				for ( c=0; c < 3; c++ )
+					map_out( x, y, 0, c ) = (*img_out)( x, y, c );
+				map_out( x, y, 0, 3 ) = ( (*img_msk)( x, y ) != 0 );
+			}
+	map_dirty.clear();
+}
+
+
+void Args::costMapDirty( uint_t x, uint_t y, uint_t w, uint_t h ) {
+	/*
+	Record that the w x h texture rect at (x,y) changed,
+	for the next update of the cost maps.
+	*/
+	rect_t rect;
+
+	/* the whole maps will be computed anyway */
+	if ( !map_valid )
+		return;
+
+	if ( map_dirty.size() >= MAP_MAX_DIRTY ) {
+		map_valid = false;
+		map_dirty.clear();
+		return;
+	}
+
+	rect.x = x % t_width;
+	rect.y = y % t_height;
+	rect.w = w;
+	rect.h = h;
+	map_dirty.push_back( rect );
+}
+
+
+/************/
+/* POSITION */
+/************/
+
+
+Args::place_t Args::placeEntireFFT() {
+	/*
+	Return a position of the top-left corner for
+	a new patch, using Exhaustive Entire Matching:
+	same criterion as placeEntireMatching(), but the
+	best of ALL offsets is returned, not the best
+	of PLACE_ENTM_TESTS random ones.
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
+	*/
+	place_t pos;
+	uint_t i, k, best=0;
+	uint_t fullarea = p_width * p_height;
+	uint_t bound = (uint_t) ( fullarea * ratio );
+	double cost = -1, ncost;
+	bool holes;
+
+	costMap();
+
+	for ( i=0; i < t_width * t_height; i++ ) {
+
+		k = count_map[ i ];
+		if ( ( k == 0 ) || ( k < bound ) )
+			continue;
+
+		/* only fill holes, until the texture is finished */
+		holes = ( k < fullarea );
+		if ( !holes && !end() )
+			continue;
+
+		/* mean on each channel, reduced when empty areas remain */
+		ncost = cost_map[ i ] / ( 3.0 * k );
+		if ( holes ) {
+			ncost *= 0.75;
+		}
+
+		if ( ( cost < 0 ) || ( ncost < cost ) ) {
+			cost = ncost;
+			best = i;
+		}
+	}
+
+	/* no offset overlaps enough */
+	if ( cost < 0 )
+		return placeRandom();
+
+	/* add coordinates on output texture */
+	pos.x = best % t_width;
+	pos.y = best / t_width;
+	/* nb of pixels overlapping */
+	pos.k = count_map[ best ];
+	/* add width limits */
+	pos.x0 = 0;
+	pos.x1 = p_width;
+	/* add height limits */
+	pos.y0 = 0;
+	pos.y1 = p_height;
+
+	return pos;
+}
+
+
+Args::place_t Args::placeProbabilistic() {
+	/*
+	Return a position of the top-left corner for
+	a new patch, using Probabilistic Entire Matching:
+	the offsets allowed by placeEntireMatching() are
+	drawn with probability exp( -C / k.sigma^2 ), C
+	being their cost, sigma^2 the variance of the
+	patch colours and k set by the user.
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
+	*/
+	place_t pos;
+	uint_t i, j, c, k, best;
+	uint_t n = t_width * t_height;
+	uint_t fullarea = p_width * p_height;
+	uint_t bound = (uint_t) ( fullarea * ratio );
+	double cost = -1, ncost, s, s2;
+	bool holes;
+
+	/* colour variance, the same whatever the patch transforms */
+	if ( prob_var < 0 ) {
+
+		s = s2 = 0;
+		for ( j=0; j < p_height; j++ )
+			for ( i=0; i < p_width; i++ )
+				for ( c=0; c < 3; c++ ) {
+					s += (*img_in)( i, j, c );
+					s2 += squares[ (*img_in)( i, j, c ) ];
+				}
+		s /= 3.0 * fullarea;
+		prob_var = s2 / ( 3.0 * fullarea ) - s * s;
+		if ( prob_var < 1 )
+			prob_var = 1;
+	}
+
+	costMap();
+
+	/* costs, as in placeEntireFFT(), -1 where not allowed */
+	prob_weights.resize( n );
+	for ( i=0; i < n; i++ ) {
+
+		prob_weights[ i ] = -1;
+		k = count_map[ i ];
+		if ( ( k == 0 ) || ( k < bound ) )
+			continue;
+
+		holes = ( k < fullarea );
+		if ( !holes && !end() )
+			continue;
+
+		ncost = cost_map[ i ] / ( 3.0 * k );
+		if ( holes ) {
+			ncost *= 0.75;
+		}
+		prob_weights[ i ] = ncost;
+		if ( ( cost < 0 ) || ( ncost < cost ) )
+			cost = ncost;
+	}
+
+	/* no offset overlaps enough */
+	if ( cost < 0 )
+		return placeRandom();
+
+	/* weights relative to the best offset, which cannot underflow */
+	for ( i=0; i < n; i++ ) {
+		if ( prob_weights[ i ] < 0 )
+			prob_weights[ i ] = 0;
+		else
+			prob_weights[ i ] = exp( ( cost - prob_weights[ i ] ) / ( prob_k * prob_var ) );
+	}
+
+	prob_table.init( prob_weights );
+	RandomStream rng( candidateSeed(), 0 );
+	best = prob_table.draw( rng );
+
+	/* add coordinates on output texture */
+	pos.x = best % t_width;
+	pos.y = best / t_width;
+	/* nb of pixels overlapping */
+	pos.k = count_map[ best ];
+	/* add width limits */
+	pos.x0 = 0;
+	pos.x1 = p_width;
+	/* add height limits */
+	pos.y0 = 0;
+	pos.y1 = p_height;
+
+	return pos;
+}
@@ -0,0 +1,326 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* argspatchmatch.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "args.h"
+
+#include <set>
+
+
+/****************/
+/* K-COHERENCE  */
+/****************/
+
+
+uint_t Args::pmDistance( uint_t q, uint_t s, uint_t bound ) {
+	/*
+	SSD between the PM_WIN x PM_WIN windows of the patch
+	around pixels q and s (j.p_width + i), their centres
+	being moved inside the patch; stops above bound.
+	*/
+	int r = PM_WIN / 2;
+	int qx = q % p_width, qy = q / p_width;
+	int sx = s % p_width, sy = s / p_width;
+	int i, j, c, d;
+	uint_t sum = 0;
+
+	qx = ( qx < r ) ? r : ( ( qx >= (int) p_width - r ) ? p_width - r - 1 : qx );
+	qy = ( qy < r ) ? r : ( ( qy >= (int) p_height - r ) ? p_height - r - 1 : qy );
+	sx = ( sx < r ) ? r : ( ( sx >= (int) p_width - r ) ? p_width - r - 1 : sx );
+	sy = ( sy < r ) ? r : ( ( sy >= (int) p_height - r ) ? p_height - r - 1 : sy );
+
+	for ( j=-r; j <= r; j++ ) {
+		for ( i=-r; i <= r; i++ )
+			for ( c=0; c < 3; c++ ) {
+				d = (int) (*img_in)( qx + i, qy + j, c ) - (int) (*img_in)( sx + i, sy + j, c );
+				sum += squares[ d < 0 ? -d : d ];
+			}
+		if ( sum >= bound )
+			return sum;
+	}
+	return sum;
+}
+
+
+void Args::pmInsert( uint_t q, uint_t s ) {
+	/*
+	Try s as one of the PM_K windows most similar to q,
+	their list being sorted by distance. Windows which
+	overlap q are not taken.
+	*/
+	uint_t * knn = &pm_knn[ q * PM_K ];
+	uint_t * dist = &pm_dist[ q * PM_K ];
+	int dx = (int) ( s % p_width ) - (int) ( q % p_width );
+	int dy = (int) ( s / p_width ) - (int) ( q / p_width );
+	uint_t d;
+	int k;
+
+	if ( ( dx < PM_WIN ) && ( dx > -PM_WIN ) && ( dy < PM_WIN ) && ( dy > -PM_WIN ) )
+		return;
+	for ( k=0; k < PM_K; k++ )
+		if ( knn[ k ] == s )
+			return;
+
+	d = pmDistance( q, s, dist[ PM_K - 1 ] );
+	if ( d >= dist[ PM_K - 1 ] )
+		return;
+
+	for ( k=PM_K - 1; ( k > 0 ) && ( dist[ k - 1 ] > d ); k-- ) {
+		knn[ k ] = knn[ k - 1 ];
+		dist[ k ] = dist[ k - 1 ];
+	}
+	knn[ k ] = s;
+	dist[ k ] = d;
+}
+
+
+void Args::pmTable() {
+	/*
+	k-coherence table: for every pixel of the patch, the
+	PM_K most similar windows of the patch, found by
+	PatchMatch (random init, then PM_ITERS passes of
+	propagation from the previous pixel, in alternate
+	scan orders, and random search at halving radii).
+	Only computed when the patch changed.
+	*/
+	uint_t n = p_width * p_height;
+	uint_t q, s, k, rad;
+	int it, x, y, dir, t;
+
+	if ( pm_patch )
+		return;
+
+	RandomStream rng( candidateSeed(), 0 );
+
+	pm_knn.assign( n * PM_K, 0 );
+	pm_dist.assign( n * PM_K, MAX_UINT32 );
+
+	for ( q=0; q < n; q++ )
+		for ( k=0; k < PM_K; k++ )
+			pmInsert( q, rng.below( n ) );
+
+	for ( it=0; it < PM_ITERS; it++ ) {
+
+		dir = ( it % 2 ) ? -1 : 1;
+
+		for ( t=0; t < (int) n; t++ ) {
+
+			q = ( dir > 0 ) ? t : n - 1 - t;
+			x = q % p_width;
+			y = q / p_width;
+
+			/* propagation: the neighbours of the previous pixel's matches */
+			if ( ( x - dir >= 0 ) && ( x - dir < (int) p_width ) )
+				for ( k=0; k < PM_K; k++ ) {
+					s = pm_knn[ ( q - dir ) * PM_K + k ];
+					if ( ( (int) ( s % p_width ) + dir >= 0 ) && ( (int) ( s % p_width ) + dir < (int) p_width ) )
+						pmInsert( q, s + dir );
+				}
+			if ( ( y - dir >= 0 ) && ( y - dir < (int) p_height ) )
+				for ( k=0; k < PM_K; k++ ) {
+					s = pm_knn[ ( q - dir * (int) p_width ) * PM_K + k ];
+					if ( ( (int) ( s / p_width ) + dir >= 0 ) && ( (int) ( s / p_width ) + dir < (int) p_height ) )
+						pmInsert( q, s + dir * (int) p_width );
+				}
+
+			/* random search around the best match */
+			s = pm_knn[ q * PM_K ];
+			for ( rad = ( p_width > p_height ) ? p_width : p_height; rad >= 1; rad /= 2 ) {
+				int sx = (int) ( s % p_width ) + (int) rng.below( 2 * rad + 1 ) - (int) rad;
+				int sy = (int) ( s / p_width ) + (int) rng.below( 2 * rad + 1 ) - (int) rad;
+				if ( ( sx >= 0 ) && ( sx < (int) p_width ) && ( sy >= 0 ) && ( sy < (int) p_height ) )
+					pmInsert( q, sy * p_width + sx );
+			}
+		}
+	}
+	pm_patch = true;
+}
+
+
+/************/
+/* POSITION */
+/************/
+
+
+Args::place_t Args::placePatchMatch() {
+	/*
+	Return a position of the top-left corner for
+	a new patch, using PatchMatch: the texture pixels
+	set around a hole know which patch pixel they were
+	copied from; the patch positions which would put,
+	on these pixels, one of the PM_K most similar patch
+	windows (k-coherence) are scored, then the best one
+	is improved by propagation to its neighbours and
+	random search at halving radii.
+	The criterion is the one of entire matching, and the
+	whole patch is pasted ( no sub-patch, unlike -P3 ).
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
+	*/
+	place_t pos;
+	vector< candidate_t > cand;
+	set< uint_t > tried;
+	uint_t fullarea = p_width * p_height;
+	uint_t f, fx, fy, i, k, s, o, rad;
+	int best, t;
+
+	if ( ( p_width < PM_WIN ) || ( p_height < PM_WIN ) )
+		return placeEntireMatching();
+
+	validOffsets();
+	if ( valid_count == 0 )
+		return placeRandom();
+	if ( lastHoles() )
+		unfilled.components();
+	pmTable();
+
+	RandomStream rng( candidateSeed(), 0 );
+
+	/* the pixel to cover: a frontier one until the texture is finished */
+	if ( !end() && unfilled.frontierSize() )
+		f = unfilled.frontier( rng.below( unfilled.frontierSize() ) );
+	else
+		f = rng.below( t_width * t_height );
+	fx = f % t_width;
+	fy = f / t_width;
+
+	/* k-coherence candidates, from texture pixels set around f */
+	for ( t=0; t < PM_SAMPLES; t++ ) {
+
+		uint_t px = ( fx + t_width + rng.below( 2 * p_width - 1 ) - ( p_width - 1 ) ) % t_width;
+		uint_t py = ( fy + t_height + rng.below( 2 * p_height - 1 ) - ( p_height - 1 ) ) % t_height;
+		uint_t src = img_src[ py * t_width + px ];
+
+		if ( src == MAX_UINT32 )
+			continue;
+
+		for ( k=0; k <= PM_K; k++ ) {
+
+			s = ( k == 0 ) ? src : pm_knn[ src * PM_K + k - 1 ];
+			/* patch pixel s on texture pixel (px,py), and f covered */
+			uint_t ox = ( px + t_width - s % p_width ) % t_width;
+			uint_t oy = ( py + t_height - s / p_width ) % t_height;
+			if ( ( ( fx + t_width - ox ) % t_width >= p_width )
+				|| ( ( fy + t_height - oy ) % t_height >= p_height ) )
+				continue;
+
+			o = oy * t_width + ox;
+			if ( valid_map[ o ] && tried.insert( o ).second ) {
+				candidate_t c;
+				c.x = ox;
+				c.y = oy;
+				cand.push_back( c );
+			}
+		}
+	}
+
+	/* a few plain random ones, when the neighbourhood says little */
+	for ( t=0; t < PM_SAMPLES / 4; t++ ) {
+		candidate_t c;
+		sampleOffset( rng, c.x, c.y );
+		if ( tried.insert( c.y * t_width + c.x ).second )
+			cand.push_back( c );
+	}
+
+	/* score them as placeEntireMatching() does */
+#ifdef _OPENMP
+#pragma omp parallel num_threads( nb_jobs )
+#endif
+	{
+		float best_cost = 0;
+		int best_i = -1;
+
+#ifdef _OPENMP
+#pragma omp for schedule( dynamic )
+#endif
+		for ( t=0; t < (int) cand.size(); t++ ) {
+			candidate_t & c = cand[ t ];
+			c.k = occupancy.sum( c.x, c.y, p_width, p_height );
+			c.valid = matchScore( c, t, 0, 0, p_width, p_height, c.k != fullarea, best_cost, best_i );
+		}
+	}
+
+	best = bestCandidate( cand );
+	if ( best < 0 )
+		return placeRandom();
+
+	/* propagation and random search around the best one */
+	candidate_t b = cand[ best ];
+	float best_cost = b.cost;
+	int best_i = 0;
+
+	for ( rad = ( p_width > p_height ) ? p_width / 2 : p_height / 2; rad >= 1; rad /= 2 ) {
+		for ( i=0; i < 4 + PM_K; i++ ) {
+
+			candidate_t c;
+			if ( i < 4 ) {
+				/* the 4 neighbours */
+				c.x = ( b.x + t_width + ( i == 0 ) - ( i == 1 ) ) % t_width;
+				c.y = ( b.y + t_height + ( i == 2 ) - ( i == 3 ) ) % t_height;
+			}
+			else {
+				c.x = ( b.x + t_width + rng.below( 2 * rad + 1 ) - rad ) % t_width;
+				c.y = ( b.y + t_height + rng.below( 2 * rad + 1 ) - rad ) % t_height;
+			}
+			o = c.y * t_width + c.x;
+			if ( !valid_map[ o ] || !tried.insert( o ).second )
+				continue;
+
+			c.k = occupancy.sum( c.x, c.y, p_width, p_height );
+			if ( matchScore( c, 1, 0, 0, p_width, p_height, c.k != fullarea, best_cost, best_i ) ) {
+				b = c;
+				best_i = 0;
+			}
+			ssd_total += c.area;
+			ssd_done += c.pixels;
+		}
+	}
+
+	/* add coordinates on output texture */
+	pos.x = b.x;
+	pos.y = b.y;
+	/* nb of pixels overlapping */
+	pos.k = b.k;
+	/* add width limits */
+	pos.x0 = 0;
+	pos.x1 = p_width;
+	/* add height limits */
+	pos.y0 = 0;
+	pos.y1 = p_height;
+
+	return pos;
+}
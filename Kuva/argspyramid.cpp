@@ -0,0 +1,313 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* argspyramid.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "args.h"
+
+
+/* 5 taps binomial filter, an approximate gaussian */
+static const float pyr_filter[5] = { 1/16.f, 4/16.f, 6/16.f, 4/16.f, 1/16.f };
+
+
+static void pyrReduce( const cimg_library::CImg< float > & src,
+					  cimg_library::CImg< float > & dst, bool wrap ) {
+	/*
+	Blur src with the binomial filter and keep one pixel out
+	of two in each direction. Borders wrap around for the
+	(toroidal) texture, and are clamped for the patch.
+	*/
+	int w = src.dimx(), h = src.dimy(), x, y, i, c, s;
+	int dw = ( w + 1 ) / 2, dh = ( h + 1 ) / 2;
+	cimg_library::CImg< float > tmp( dw, h, 1, src.dimv() );
+
+	/* rows */
+	for ( c=0; c < src.dimv(); c++ )
+		for ( y=0; y < h; y++ )
+			for ( x=0; x < dw; x++ ) {
+				float v = 0;
+				for ( i=0; i < 5; i++ ) {
+					s = 2 * x + i - 2;
+					if ( wrap )
+						s = ( s + w ) % w;
+					else
+						s = ( s < 0 ) ? 0 : ( ( s >= w ) ? w - 1 : s );
+					v += pyr_filter[ i ] * src( s, y, 0, c );
+				}
+				tmp( x, y, 0, c ) = v;
+			}
+
+	/* columns */
+	dst = cimg_library::CImg< float >( dw, dh, 1, src.dimv() );
+	for ( c=0; c < src.dimv(); c++ )
+		for ( y=0; y < dh; y++ )
+			for ( x=0; x < dw; x++ ) {
+				float v = 0;
+				for ( i=0; i < 5; i++ ) {
+					s = 2 * y + i - 2;
+					if ( wrap )
+						s = ( s + h ) % h;
+					else
+						s = ( s < 0 ) ? 0 : ( ( s >= h ) ? h - 1 : s );
+					v += pyr_filter[ i ] * tmp( x, s, 0, c );
+				}
+				dst( x, y, 0, c ) = v;
+			}
+}
+
+
+static void pyrInsert( vector< Args::candidate_t > & best, const Args::candidate_t & c ) {
+	/*
+	Insert c in the list of the PYR_CANDIDATES best candidates,
+	sorted by cost, after the ones of same cost.
+	*/
+	uint_t i;
+
+	for ( i=0; i < best.size(); i++ ) {
+		if ( ( best[ i ].x == c.x ) && ( best[ i ].y == c.y ) )
+			return;
+	}
+	if ( ( best.size() == PYR_CANDIDATES ) && !( c.cost < best.back().cost ) )
+		return;
+
+	for ( i=0; i < best.size() && !( c.cost < best[ i ].cost ); i++ );
+	best.insert( best.begin() + i, c );
+	if ( best.size() > PYR_CANDIDATES )
+		best.pop_back();
+}
+
+
+/***********/
+/* PYRAMID */
+/***********/
+
+
+void Args::pyramid() {
+	/*
+	Build the gaussian pyramids of the patch (only when it
+	changed) and of the texture, down to patches of about
+	PYR_MIN_SIZE pixels. Texture levels have four channels,
+	the colours weighted by the mask, and the mask (the
+	fraction of the area already set), so that holes do not
+	bleed into the colours.
+	*/
+	uint_t i, j, c, l, levels = 1;
+
+	while ( ( levels < PYR_MAX_LEVELS )
+		&& ( ( p_width >> levels ) >= PYR_MIN_SIZE )
+		&& ( ( p_height >> levels ) >= PYR_MIN_SIZE ) )
+		levels++;
+
+	if ( !pyr_patch || ( pyr_in.size() != levels ) ) {
+
+		pyr_in.resize( levels );
+		pyr_in[0] = cimg_library::CImg< float >( p_width, p_height, 1, 3 );
+		for ( j=0; j < p_height; j++ )
+			for ( i=0; i < p_width; i++ )
+				for ( c=0; c < 3; c++ )
+					pyr_in[0]( i, j, 0, c ) = (*img_in)( i, j, c );
+
+		for ( l=1; l < levels; l++ )
+			pyrReduce( pyr_in[ l - 1 ], pyr_in[ l ], false );
+		pyr_patch = true;
+	}
+
+	pyr_out.resize( levels );
+	pyr_out[0] = cimg_library::CImg< float >( t_width, t_height, 1, 4 );
+	for ( j=0; j < t_height; j++ )
+		for ( i=0; i < t_width; i++ ) {
+			float m = ( (*img_msk)( i, j ) != 0 ) ? 1.f : 0.f;
+			for ( c=0; c < 3; c++ )
+				pyr_out[0]( i, j, 0, c ) = m * (*img_out)( i, j, c );
+			pyr_out[0]( i, j, 0, 3 ) = m;
+		}
+
+	for ( l=1; l < levels; l++ )
+		pyrReduce( pyr_out[ l - 1 ], pyr_out[ l ], true );
+}
+
+
+void Args::pyramidCost( uint_t l, candidate_t & c ) {
+	/*
+	Cost of the patch at offset (c.x,c.y) of level l, with the
+	criterion of placeEntireMatching(): mean SSD on the pixels
+	set, reduced when the patch covers holes; c.valid is false
+	when the offset does not overlap enough, or only covers
+	pixels already set.
+	At full resolution the exact SSD and overlap are used, on
+	coarser levels they are weighted by the mask.
+	*/
+	uint_t fullarea = p_width * p_height;
+	uint_t bound = (uint_t) ( fullarea * ratio );
+	bool holes;
+
+	if ( l == 0 ) {
+
+		unsigned long long sums[3];
+
+		c.k = occupancy.sum( c.x, c.y, p_width, p_height );
+		holes = ( c.k != fullarea );
+		c.valid = ( c.k > 0 ) && ( c.k >= bound ) && ( end() || holes );
+		if ( !c.valid )
+			return;
+
+		ssdWindow( c.x, c.y, 0, 0, p_width, p_height, sums );
+		c.cost = matchCost( sums, c.k, holes );
+	}
+	else {
+
+		const cimg_library::CImg< float > & in = pyr_in[ l ];
+		const cimg_library::CImg< float > & out = pyr_out[ l ];
+		uint_t w = in.dimx(), h = in.dimy();
+		uint_t tw = out.dimx(), th = out.dimy();
+		/* area of a pixel of the level, in full resolution pixels */
+		float scale = (float) fullarea / ( w * h );
+		double ssd = 0, k = 0;
+		uint_t i, j, tx, ty;
+
+		for ( j=0, ty = c.y; j < h; j++, ty = ( ty + 1 == th ) ? 0 : ty + 1 )
+			for ( i=0, tx = c.x; i < w; i++, tx = ( tx + 1 == tw ) ? 0 : tx + 1 ) {
+
+				float m = out( tx, ty, 0, 3 );
+				if ( m <= 0 )
+					continue;
+				for ( int ch=0; ch < 3; ch++ ) {
+					float d = in( i, j, 0, ch ) - out( tx, ty, 0, ch ) / m;
+					ssd += m * d * d;
+				}
+				k += m;
+			}
+
+		/* holes of less than half a pixel are blurred away */
+		holes = ( ( w * h - k ) * scale >= 0.5 );
+		c.k = (uint_t) ( k * scale + 0.5 );
+		c.valid = ( k > 0 ) && ( k * scale >= bound ) && ( end() || holes );
+		if ( !c.valid )
+			return;
+
+		c.cost = (float) ( ssd / ( 3 * k ) );
+		if ( holes ) {
+			c.cost *= 0.75;
+		}
+	}
+}
+
+
+/************/
+/* POSITION */
+/************/
+
+
+Args::place_t Args::placePyramid() {
+	/*
+	Return a position of the top-left corner for
+	a new patch, using Pyramid Matching: every offset
+	of the coarsest level is tried, then the
+	PYR_CANDIDATES best ones are refined in a
+	neighbourhood of PYR_RADIUS pixels on each
+	finer level, with the criterion of
+	placeEntireMatching().
+	x: X coordinate
+	y: Y coordinate
+	k: #pixels overlapping
+	*/
+	place_t pos;
+	vector< candidate_t > best, cand;
+	uint_t i, tw, th;
+	int l, n, d = 2 * PYR_RADIUS + 1;
+
+	pyramid();
+	occupancy.total();
+
+	/* coarsest level: all offsets */
+	l = (int) pyr_out.size() - 1;
+	tw = pyr_out[ l ].dimx();
+	th = pyr_out[ l ].dimy();
+	cand.resize( tw * th );
+	for ( i=0; i < tw * th; i++ ) {
+		cand[ i ].x = i % tw;
+		cand[ i ].y = i / tw;
+	}
+
+	for ( ; ; ) {
+
+		/* costs in parallel, then a serial (deterministic) selection */
+		n = (int) cand.size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads( nb_jobs ) schedule( dynamic, 16 )
+#endif
+		for ( int c=0; c < n; c++ )
+			pyramidCost( l, cand[ c ] );
+
+		best.clear();
+		for ( i=0; i < cand.size(); i++ )
+			if ( cand[ i ].valid )
+				pyrInsert( best, cand[ i ] );
+
+		if ( ( l == 0 ) || best.empty() )
+			break;
+
+		/* next level: neighbourhoods of the best offsets */
+		l--;
+		tw = pyr_out[ l ].dimx();
+		th = pyr_out[ l ].dimy();
+		cand.clear();
+		for ( i=0; i < best.size(); i++ )
+			for ( int k=0; k < d * d; k++ ) {
+				candidate_t c;
+				c.x = ( 2 * best[ i ].x + tw * 2 + k % d - PYR_RADIUS ) % tw;
+				c.y = ( 2 * best[ i ].y + th * 2 + k / d - PYR_RADIUS ) % th;
+				cand.push_back( c );
+			}
+	}
+
+	/* no offset overlaps enough */
+	if ( best.empty() )
+		return placeRandom();
+
+	/* add coordinates on output texture */
+	pos.x = best[0].x;
+	pos.y = best[0].y;
+	/* nb of pixels overlapping */
+	pos.k = best[0].k;
+	/* add width limits */
+	pos.x0 = 0;
+	pos.x1 = p_width;
+	/* add height limits */
+	pos.y0 = 0;
+	pos.y1 = p_height;
+
+	return pos;
+}
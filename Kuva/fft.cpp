@@ -0,0 +1,249 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* fft.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "fft.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+/*******/
+/* 1D  */
+/*******/
+
+
+void FFT::init( unsigned int size ) {
+	/*
+	Precompute twiddles, bit reversal and (if size is not
+	a power of two) Bluestein's chirp for the given length.
+	*/
+	unsigned int i, bits;
+
+	if ( size == n )
+		return;
+	n = size;
+
+	/* smallest power of two which can hold the transform */
+	m = 1;
+	if ( n & ( n - 1 ) ) {
+		while ( m < 2 * n - 1 )
+			m <<= 1;
+	}
+	else {
+		m = n;
+	}
+
+	roots.resize( m / 2 + 1 );
+	for ( i=0; i < m / 2; i++ )
+		roots[ i ] = std::polar( 1.0, -2 * M_PI * i / m );
+
+	for ( bits=0; ( 1u << bits ) < m; bits++ );
+	rev.resize( m );
+	for ( i=0; i < m; i++ ) {
+		unsigned int r = 0, k;
+		for ( k=0; k < bits; k++ )
+			if ( i & ( 1u << k ) )
+				r |= 1u << ( bits - 1 - k );
+		rev[ i ] = r;
+	}
+
+	chirp.clear();
+	kernel.clear();
+	work.clear();
+
+	if ( m == n )
+		return;
+
+	/* Bluestein: X(k) = w(k) . sum_j x(j).w(j).conj(w(k-j)) */
+	chirp.resize( n );
+	for ( i=0; i < n; i++ ) {
+		/* k^2 mod 2n keeps the angle small, hence accurate */
+		unsigned long long k2 = (unsigned long long) i * i % ( 2 * n );
+		chirp[ i ] = std::polar( 1.0, -M_PI * (double) k2 / n );
+	}
+
+	kernel.assign( m, cplx_t( 0, 0 ) );
+	kernel[ 0 ] = std::conj( chirp[ 0 ] );
+	for ( i=1; i < n; i++ ) {
+		kernel[ i ] = kernel[ m - i ] = std::conj( chirp[ i ] );
+	}
+	radix2( &kernel[ 0 ], false );
+
+	work.resize( m );
+}
+
+
+void FFT::radix2( cplx_t * data, bool inv ) {
+	/*
+	In place iterative radix-2 transform of length m (not scaled).
+	*/
+	unsigned int i, j, len, half, step;
+
+	for ( i=0; i < m; i++ )
+		if ( i < rev[ i ] )
+			std::swap( data[ i ], data[ rev[ i ] ] );
+
+	for ( len=2; len <= m; len <<= 1 ) {
+
+		half = len >> 1;
+		step = m / len;
+
+		for ( i=0; i < m; i += len )
+			for ( j=0; j < half; j++ ) {
+
+				cplx_t w = roots[ j * step ];
+				if ( inv )
+					w = std::conj( w );
+
+				cplx_t u = data[ i + j ];
+				cplx_t v = data[ i + j + half ] * w;
+				data[ i + j ] = u + v;
+				data[ i + j + half ] = u - v;
+			}
+	}
+}
+
+
+void FFT::transform( cplx_t * data, bool inv ) {
+	/*
+	Transform of length n, inverse is scaled by 1/n.
+	*/
+	unsigned int i;
+
+	if ( n <= 1 )
+		return;
+
+	if ( m == n ) {
+		radix2( data, inv );
+	}
+	else {
+		/* inverse(x) = conj( forward( conj(x) ) ) */
+		for ( i=0; i < n; i++ )
+			work[ i ] = ( inv ? std::conj( data[ i ] ) : data[ i ] ) * chirp[ i ];
+		for ( ; i < m; i++ )
+			work[ i ] = 0;
+
+		radix2( &work[ 0 ], false );
+		for ( i=0; i < m; i++ )
+			work[ i ] *= kernel[ i ];
+		radix2( &work[ 0 ], true );
+
+		for ( i=0; i < n; i++ ) {
+			data[ i ] = work[ i ] * chirp[ i ] / (double) m;
+			if ( inv )
+				data[ i ] = std::conj( data[ i ] );
+		}
+	}
+
+	if ( inv ) {
+		for ( i=0; i < n; i++ )
+			data[ i ] /= (double) n;
+	}
+}
+
+
+/*******/
+/* 2D  */
+/*******/
+
+
+void FFT2D::init( unsigned int w, unsigned int h ) {
+	/*
+	Prepare row and column transforms.
+	*/
+	width = w;
+	height = h;
+	rows.init( w );
+	cols.init( h );
+	column.resize( h );
+}
+
+
+void FFT2D::transform( cplx_t * img, bool inv ) {
+	/*
+	Separable 2D transform: rows, then columns.
+	*/
+	unsigned int x, y;
+
+	for ( y=0; y < height; y++ ) {
+		if ( inv )
+			rows.inverse( img + y * width );
+		else
+			rows.forward( img + y * width );
+	}
+
+	for ( x=0; x < width; x++ ) {
+
+		for ( y=0; y < height; y++ )
+			column[ y ] = img[ y * width + x ];
+
+		if ( inv )
+			cols.inverse( &column[ 0 ] );
+		else
+			cols.forward( &column[ 0 ] );
+
+		for ( y=0; y < height; y++ )
+			img[ y * width + x ] = column[ y ];
+	}
+}
+
+
+void FFT2D::forward2( cplx_t * img, cplx_t * spec_a, cplx_t * spec_b ) {
+	/*
+	Split the spectrum of a + i.b using the hermitian symmetry
+	of real signals spectra:
+	A(f) = ( Z(f) + conj(Z(-f)) ) / 2
+	B(f) = ( Z(f) - conj(Z(-f)) ) / 2i
+	*/
+	unsigned int x, y;
+
+	forward( img );
+
+	for ( y=0; y < height; y++ )
+		for ( x=0; x < width; x++ ) {
+
+			cplx_t z = img[ y * width + x ];
+			cplx_t zc = std::conj( img[ ( ( height - y ) % height ) * width
+				+ ( width - x ) % width ] );
+
+			spec_a[ y * width + x ] = ( z + zc ) * 0.5;
+			spec_b[ y * width + x ] = ( z - zc ) * cplx_t( 0, -0.5 );
+		}
+}
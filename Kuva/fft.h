@@ -0,0 +1,130 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* fft.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Complex FFT of any length, and its 2D version.
+
+	Power of two lengths use an iterative radix-2 transform,
+	other lengths go through Bluestein's chirp-z algorithm
+	(a circular convolution computed with a power of two FFT),
+	so that toroidal images of any size can be correlated.
+
+	Transforms are done in place and the inverse is scaled by
+	1/n, so inverse( forward( x ) ) == x.
+*/
+
+#ifndef K_FFT
+#define K_FFT
+
+#include <complex>
+#include <vector>
+
+typedef std::complex< double > cplx_t;
+
+
+class FFT {
+
+public:
+
+	FFT() { n = m = 0; };
+
+	/* prepare transforms of length 'size' */
+	void init( unsigned int size );
+
+	unsigned int size() { return n; };
+
+	void forward( cplx_t * data ) { transform( data, false ); };
+
+	void inverse( cplx_t * data ) { transform( data, true ); };
+
+protected:
+
+	unsigned int n; /* transform length */
+	unsigned int m; /* radix-2 length (n, or Bluestein's padding) */
+
+	/* e^(-2i.pi.k/m), k < m/2 */
+	std::vector< cplx_t > roots;
+	/* bit reversal permutation for m */
+	std::vector< unsigned int > rev;
+
+	/* Bluestein chirp e^(-i.pi.k^2/n), and the spectrum of its conjugate */
+	std::vector< cplx_t > chirp;
+	std::vector< cplx_t > kernel;
+	std::vector< cplx_t > work;
+
+	void transform( cplx_t * data, bool inv );
+
+	void radix2( cplx_t * data, bool inv );
+};
+
+
+class FFT2D {
+
+public:
+
+	FFT2D() { width = height = 0; };
+
+	/* prepare transforms of w x h images (row major) */
+	void init( unsigned int w, unsigned int h );
+
+	unsigned int getWidth() { return width; };
+	unsigned int getHeight() { return height; };
+
+	void forward( cplx_t * img ) { transform( img, false ); };
+
+	void inverse( cplx_t * img ) { transform( img, true ); };
+
+	/*
+	Forward transforms of two real images a and b at once:
+	on input img holds a + i.b, on output spec_a and spec_b
+	hold the spectra of a and b (img is destroyed).
+	*/
+	void forward2( cplx_t * img, cplx_t * spec_a, cplx_t * spec_b );
+
+protected:
+
+	unsigned int width;
+	unsigned int height;
+
+	FFT rows;
+	FFT cols;
+	std::vector< cplx_t > column;
+
+	void transform( cplx_t * img, bool inv );
+};
+
+#endif
@@ -37,25 +37,24 @@
 
 
 /*
-	For description, example usage, discussion of graph representation
-	and memory usage see README.TXT.
+	For description and example usage see README.TXT; the graph
+	representation and its memory usage are described below.
 */
 
 #ifndef __GRAPH_H__
 #define __GRAPH_H__
 
-#include "block.h"
+#include <stdlib.h>
+#include <vector>
 
 /*
-	Nodes, arcs and pointers to nodes are
-	added in blocks for memory and time efficiency.
-	Below are numbers of items in blocks
+	Nodes and arcs are numbered on 32 bit signed indices,
+	on any host: at most 2^31 - 1 nodes and 2^30 - 1 edges
 */
-#define NODE_BLOCK_SIZE 512
-#define ARC_BLOCK_SIZE 1024
-#define NODEPTR_BLOCK_SIZE 128
+#define MAX_NODES 0x7fffffff
+#define MAX_ARCS  0x7ffffffe
 
-class Graph
+template < class cap_t, class flow_t > class Graph
 {
 public:
   typedef enum
@@ -64,14 +63,14 @@ public:
       SINK	= 1
     } termtype; /* terminals */
 
-  /* Type of edge weights.
-     Can be changed to char, int, float, double, ... */
-
-  typedef short captype;
+  /* Type of edge weights: char, short, int, float, double, ...
+     ( see the instances below ) */
+  typedef cap_t captype;
   /* Type of total flow */
-  typedef unsigned flowtype;
+  typedef flow_t flowtype;
 
-  typedef void * node_id;
+  /* nodes are numbered from 0, in the order of add_node() */
+  typedef int node_id;
 
   /* interface functions */
 
@@ -101,12 +100,46 @@ public:
      Weights can be negative */
   void add_tweights(node_id i, captype cap_source, captype cap_sink);
 
+  /* Number of nodes */
+  int get_node_num() { return (int) nodes.size(); }
+
+  /* Reuse of the search trees ( as in Kolmogorov's maxflow 3 ):
+     after 'maxflow()', nodes and edges may be added, and terminal
+     weights with 'add_tweights()'; 'maxflow(true)' then starts from
+     the flow and the trees of the previous run. It serves the merge
+     of 'maxflow_parallel()', where the edges between the subgraphs
+     are the ones added. */
+
+  /* Marks node i for the next 'maxflow(true)', which checks its
+     tree and its arcs again. Needed after 'add_tweights()' on a
+     node of a graph already cut; new nodes and the ends of new
+     edges are marked by 'maxflow(true)' */
+  void mark_node(node_id i);
+
   /* After the maxflow is computed, this function returns to which
      segment the node 'i' belongs (Graph::SOURCE or Graph::SINK) */
   termtype what_segment(node_id i);
 
-  /* Computes the maxflow. Can be called only once. */
-  flowtype maxflow();
+  /* Computes the maxflow. With 'reuse_trees', starts from the
+     previous one ( see the reuse of the trees above ), otherwise
+     from scratch */
+  flowtype maxflow(bool reuse_trees = false);
+
+  /* Computes the maxflow on 'parts' threads ( with OpenMP ): the
+     node numbers are split in 'parts' ranges of consecutive ones,
+     whose maxflows are computed at once, each on its own subgraph;
+     the maxflow of the whole graph then goes on from theirs, with
+     the edges between them as new ones ( see the reuse of the trees ).
+     Same cut as 'maxflow()'; it only pays when the nodes were added
+     in an order which leaves few edges between the ranges, e.g.
+     strip by strip on a grid */
+  flowtype maxflow_parallel(int parts);
+
+  /* Removes all nodes and edges, to build a new graph.
+     The memory is kept for the new graph: once a graph
+     object has held the largest graph needed, it does not
+     allocate memory any more */
+  void reset();
 
   /***********************************************************************/
   /***********************************************************************/
@@ -115,117 +148,48 @@ public:
 private:
   /* internal variables and functions */
 
-  struct arc_forward_st;
-  struct arc_reverse_st;
+  /* special values of node::parent, which is otherwise
+     the arc from the node to its parent in the tree */
+  enum { PARENT_NONE = -1, PARENT_TERMINAL = -2, PARENT_ORPHAN = -3 };
+
+  /*
+    Arrays indexed by node or arc numbers, no pointers.
 
-#define IS_ODD(a) ((int)(a) & 1)
-#define MAKE_ODD(a)  ((arc_forward *) ((int)(a) | 1))
-#define MAKE_EVEN(a) ((arc_forward *) ((int)(a) & (~1)))
-#define MAKE_ODD_REV(a)  ((arc_reverse *) ((int)(a) | 1))
-#define MAKE_EVEN_REV(a) ((arc_reverse *) ((int)(a) & (~1)))
+    Edge e makes arcs 2e ( from -> to ) and 2e+1 ( to -> from ):
+    the sister of arc a is a^1, its tail is head[a^1], and the
+    capacities of both are side by side. The arcs of node i are
+    arcs[ first[i] ] ... arcs[ first[i+1]-1 ] ( see prepare_graph() ).
 
-  /* node structure */
+    'node' holds all that the growth of the trees and the adoption
+    touch on a node, apart from its arcs ( 20 bytes with 16 bit
+    capacities ).
+  */
   typedef struct node_st
   {
-    /*
-      Usually i->first_out is the first outgoing
-      arc, and (i+1)->first_out-1 is the last outgoing arc.
-      However, it is not always possible, since
-      arcs are allocated in blocks, so arcs corresponding
-      to two consecutive nodes may be in different blocks.
-
-      If outgoing arcs for i are last in the arc block,
-      then a different mechanism is used. i->first_out
-      is odd in this case; the first outgoing arc
-      is (a+1), and the last outgoing arc is
-      ((arc_forward *)(a->shift))-1, where
-      a = (arc_forward *) (((char *)(i->first_out)) + 1);
-
-      Similar mechanism is used for incoming arcs.
-    */
-    arc_forward_st	*first_out;	/* first outcoming arc */
-    arc_reverse_st	*first_in;	/* first incoming arc */
-
-    arc_forward_st	*parent;	/* describes node's parent
-					   if IS_ODD(parent) then MAKE_EVEN(parent) points to 'arc_reverse',
-					   otherwise parent points to 'arc_forward' */
-
-    node_st			*next;		/* pointer to the next active node
-						   (or to itself if it is the last node in the list) */
-
-    int				TS;			/* timestamp showing when DIST was computed */
-    int				DIST;		/* distance to the terminal */
-    short			is_sink;	/* flag showing whether the node is in the source or in the sink tree */
-
-    captype			tr_cap;		/* if tr_cap > 0 then tr_cap is residual capacity of the arc SOURCE->node
-						   otherwise         -tr_cap is residual capacity of the arc node->SINK */
+    int			parent;		/* arc to the parent, or PARENT_* */
+    int			next;		/* next active node, -1 if not active
+					   ( itself if it is the last node in the list ) */
+    int			TS;		/* timestamp showing when DIST was computed */
+    int			DIST;		/* distance to the terminal */
+    captype		tr_cap;		/* if tr_cap > 0 then tr_cap is residual capacity of the arc SOURCE->node
+					   otherwise         -tr_cap is residual capacity of the arc node->SINK */
+    unsigned char	is_sink;	/* flag showing whether the node is in the source or in the sink tree */
+    unsigned char	is_marked;	/* set by mark_node(), until the next maxflow(true) */
   } node;
 
-  /* arc structures */
-#define NEIGHBOR_NODE(i, shift) ((node *) ((char *)(i) + (shift)))
-#define NEIGHBOR_NODE_REV(i, shift) ((node *) ((char *)(i) - (shift)))
-  typedef struct arc_forward_st
-  {
-    int				shift;		/* node_to = NEIGHBOR_NODE(node_from, shift) */
-    captype			r_cap;		/* residual capacity */
-    captype			r_rev_cap;	/* residual capacity of the reverse arc*/
-  } arc_forward;
+  std::vector< node >		nodes;
+  std::vector< int >		head;	/* per arc: node it goes to */
+  std::vector< captype >	r_cap;	/* per arc: residual capacity */
+  std::vector< int >		first;	/* per node: its first entry in arcs */
+  std::vector< int >		arcs;	/* arcs out of the nodes, node by node */
 
-  typedef struct arc_reverse_st
-  {
-    arc_forward		*sister;	/* reverse arc */
-  } arc_reverse;
-
-  /* 'pointer to node' structure */
-  typedef struct nodeptr_st
-  {
-    node_st			*ptr;
-    nodeptr_st		*next;
-  } nodeptr;
-
-  typedef struct node_block_st
-  {
-    node					*current;
-    struct node_block_st	*next;
-    node					nodes[NODE_BLOCK_SIZE];
-  } node_block;
+  std::vector< int >		marked;	/* nodes marked since the last maxflow() */
+  int				n_done, m_done;	/* nodes and arcs of the last maxflow() */
 
-#define last_node LAST_NODE.LAST_NODE
-
-  typedef struct arc_for_block_st
-  {
-    char					*start;		/* the actual start address of this block.
-								   May be different from 'this' since 'this'
-								   must be at an even address. */
-    arc_forward				*current;
-    struct arc_for_block_st	*next;
-    arc_forward				arcs_for[ARC_BLOCK_SIZE]; /* all arcs must be at even addresses */
-    union
-    {
-      arc_forward			dummy;
-      node				*LAST_NODE;	/* used in graph consruction */
-    }						LAST_NODE;
-  } arc_for_block;
-
-  typedef struct arc_rev_block_st
-  {
-    char					*start;		/* the actual start address of this block.
-								   May be different from 'this' since 'this'
-								   must be at an even address. */
-    arc_reverse				*current;
-    struct arc_rev_block_st	*next;
-    arc_reverse				arcs_rev[ARC_BLOCK_SIZE]; /* all arcs must be at even addresses */
-    union
-    {
-      arc_reverse			dummy;
-      node				*LAST_NODE;	/* used in graph consruction */
-    }						LAST_NODE;
-  } arc_rev_block;
-
-  node_block			*node_block_first;
-  arc_for_block		*arc_for_block_first;
-  arc_rev_block		*arc_rev_block_first;
-  DBlock<nodeptr>		*nodeptr_block;
+  /* subgraphs of maxflow_parallel(), and the arc of the graph
+     of the first arc of each of their edges */
+  std::vector< Graph * >		part_graph;
+  std::vector< std::vector< int > >	part_arcs;
 
   void	(*error_function)(char *);	/* this function is called if a error occurs,
 					   with a corresponding error message
@@ -235,21 +199,33 @@ private:
 
   /***********************************************************************/
 
-  node				*queue_first[2], *queue_last[2];	/* list of active nodes */
-  nodeptr				*orphan_first, *orphan_last;		/* list of pointers to orphans */
-  int					TIME;								/* monotonically increasing global counter */
+  int				queue_first[2], queue_last[2];	/* list of active nodes */
+  std::vector< int >		orphans;	/* orphans made by augment() */
+  std::vector< int >		adoption;	/* orphans made while adopting them */
+  int				TIME;		/* monotonically increasing global counter */
 
   /***********************************************************************/
 
   /* functions for processing active list */
-  void set_active(node *i);
-  node *next_active();
+  void set_active(int i);
+  int next_active();
 
   void prepare_graph();
   void maxflow_init();
-  void augment(node *s_start, node *t_start, captype *cap_middle, captype *rev_cap_middle);
-  void process_source_orphan(node *i);
-  void process_sink_orphan(node *i);
+  void maxflow_reuse_trees_init();
+  void augment(int s_start, int t_start, int a_middle);
+  void process_source_orphan(int i);
+  void process_sink_orphan(int i);
 };
 
+/*
+	Instances, compiled in graph.cpp and maxflow.cpp:
+	16 bit capacities, the most compact, and floats for
+	costs which are not rounded. Rounded costs always fit
+	in 16 bits ( see Args::getArgs() ): other instances
+	would only need a line here and in both files.
+*/
+typedef Graph< short, unsigned > Graph16;
+typedef Graph< float, double > GraphFloat;
+
 #endif
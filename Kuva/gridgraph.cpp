@@ -0,0 +1,590 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* gridgraph.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "gridgraph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INFINITE_D 1000000000 /* infinite distance to the terminal */
+
+
+/*********/
+/* BUILD */
+/*********/
+
+
+void GridGraph::reset( int w, int h ) {
+	/*
+	w x h pixels, none of them a node yet; the arrays
+	only grow.
+	*/
+	int d, size;
+	node blank = { { 0, 0, 0, 0 }, 0, PARENT_NONE, 0, -1, 0, 0 };
+
+	width = w + 2;
+	n = width * ( h + 2 );
+	size = n;
+
+	offset[ LEFT ] = -1;
+	offset[ RIGHT ] = 1;
+	offset[ UP ] = -width;
+	offset[ DOWN ] = width;
+
+	/* via is only read where crossed is set */
+	for ( d=0; d < 4; d++ )
+		via[ d ].resize( size );
+	crossed.assign( size, 0 );
+	nodes.assign( size, blank );
+	ends.clear();
+	dir.clear();
+	pending.clear();
+	flow = 0;
+}
+
+
+GridGraph::node_id GridGraph::add_node( int x, int y ) {
+
+	return ( y + 1 ) * width + x + 1;
+}
+
+
+GridGraph::node_id GridGraph::add_node() {
+	/*
+	Seam nodes only use the first two directions.
+	*/
+	node blank = { { 0, 0, 0, 0 }, 0, PARENT_NONE, 0, -1, 0, 0 };
+
+	nodes.push_back( blank );
+	ends.push_back( -1 );
+	ends.push_back( -1 );
+	dir.push_back( 0 );
+	pending.push_back( 0 );
+
+	return (int) nodes.size() - 1;
+}
+
+
+void GridGraph::add_edge( node_id from, node_id to, captype cap_, captype rev_cap ) {
+	/*
+	Pixel to pixel: the direction is given by the difference
+	of the indices. Seam node to pixel: the arcs are set when
+	the second pixel is known, with the direction between them.
+	*/
+	int d, s, a, b;
+
+	if ( from < n && to >= n ) {
+		add_edge( to, from, rev_cap, cap_ );
+		return;
+	}
+
+	if ( from < n ) {
+
+		for ( d=0; d < 4; d++ )
+			if ( to == from + offset[ d ] )
+				break;
+		if ( d == 4 ) {
+			fprintf( stderr, "GridGraph: edge between pixels not neighbours\n" );
+			exit( 1 );
+		}
+		nodes[ from ].cap[ d ] += cap_;
+		nodes[ to ].cap[ d ^ 1 ] += rev_cap;
+		return;
+	}
+
+	s = from - n;
+
+	if ( ends[ 2 * s ] < 0 ) {
+		ends[ 2 * s ] = to;
+		nodes[ from ].cap[ 0 ] = cap_;
+		pending[ s ] = rev_cap;
+		return;
+	}
+
+	a = ends[ 2 * s ];
+	b = ends[ 2 * s + 1 ] = to;
+	nodes[ from ].cap[ 1 ] = cap_;
+
+	if ( b == a + 1 )
+		dir[ s ] = RIGHT;
+	else if ( b == a + width )
+		dir[ s ] = DOWN;
+	else {
+		fprintf( stderr, "GridGraph: seam node between pixels not neighbours\n" );
+		exit( 1 );
+	}
+
+	/* the arcs between a and b go through the seam node */
+	via[ dir[ s ] ][ a ] = s;
+	via[ dir[ s ] ^ 1 ][ b ] = s;
+	crossed[ a ] |= 1 << dir[ s ];
+	crossed[ b ] |= 1 << ( dir[ s ] ^ 1 );
+	nodes[ a ].cap[ dir[ s ] ] = pending[ s ];
+	nodes[ b ].cap[ dir[ s ] ^ 1 ] = rev_cap;
+}
+
+
+void GridGraph::set_tweights( node_id i, captype cap_source, captype cap_sink ) {
+
+	flow += ( cap_source < cap_sink ) ? cap_source : cap_sink;
+	nodes[ i ].tr_cap = cap_source - cap_sink;
+}
+
+
+GridGraph::termtype GridGraph::what_segment( node_id i ) {
+
+	if ( nodes[ i ].parent != PARENT_NONE && !nodes[ i ].is_sink )
+		return SOURCE;
+	return SINK;
+}
+
+
+/***********/
+/* MAXFLOW */
+/***********/
+
+/*
+Same as maxflow.cpp, with indices for pointers and the
+direction of an arc for the arc itself: see there for the
+details of the algorithm.
+*/
+
+
+void GridGraph::set_active( int i ) {
+	/*
+	Add node i at the end of the active list, if not there.
+	*/
+	if ( nodes[ i ].next < 0 ) {
+		if ( queue_last[ 1 ] >= 0 )
+			nodes[ queue_last[ 1 ] ].next = i;
+		else
+			queue_first[ 1 ] = i;
+		queue_last[ 1 ] = i;
+		nodes[ i ].next = i;
+	}
+}
+
+
+int GridGraph::next_active() {
+	/*
+	Next active node, or -1. A node may have become
+	free while in the list, it is then skipped.
+	*/
+	int i;
+
+	while ( 1 ) {
+
+		if ( ( i = queue_first[ 0 ] ) < 0 ) {
+			queue_first[ 0 ] = i = queue_first[ 1 ];
+			queue_last[ 0 ] = queue_last[ 1 ];
+			queue_first[ 1 ] = queue_last[ 1 ] = -1;
+			if ( i < 0 )
+				return -1;
+		}
+
+		if ( nodes[ i ].next == i )
+			queue_first[ 0 ] = queue_last[ 0 ] = -1;
+		else
+			queue_first[ 0 ] = nodes[ i ].next;
+		nodes[ i ].next = -1;
+
+		if ( nodes[ i ].parent != PARENT_NONE )
+			return i;
+	}
+}
+
+
+void GridGraph::maxflow_init() {
+	/*
+	Terminal nodes are the roots of the trees, and active.
+	*/
+	int i, size = (int) nodes.size();
+
+	orphans.clear();
+	adoption.clear();
+
+	queue_first[ 0 ] = queue_last[ 0 ] = -1;
+	queue_first[ 1 ] = queue_last[ 1 ] = -1;
+	time = 0;
+
+	for ( i=0; i < size; i++ ) {
+
+		nodes[ i ].next = -1;
+		nodes[ i ].ts = 0;
+		nodes[ i ].parent = PARENT_NONE;
+
+		if ( nodes[ i ].tr_cap > 0 ) {
+			nodes[ i ].is_sink = 0;
+			nodes[ i ].parent = PARENT_TERMINAL;
+			set_active( i );
+			nodes[ i ].dist = 1;
+		}
+		else if ( nodes[ i ].tr_cap < 0 ) {
+			nodes[ i ].is_sink = 1;
+			nodes[ i ].parent = PARENT_TERMINAL;
+			set_active( i );
+			nodes[ i ].dist = 1;
+		}
+	}
+}
+
+
+void GridGraph::augment( int s, int t, int d ) {
+	/*
+	Push the bottleneck along the path SOURCE -> s -> t -> SINK,
+	through arc d of s; saturated tree arcs make orphans.
+	*/
+	int i, j, a, b;
+	captype bottleneck;
+
+	/* bottleneck: middle arc, source tree, sink tree */
+	bottleneck = nodes[ s ].cap[ d ];
+	for ( i=s; ; i=j ) {
+		a = nodes[ i ].parent;
+		if ( a == PARENT_TERMINAL )
+			break;
+		j = head( i, a );
+		b = sister( i, a );
+		if ( bottleneck > nodes[ j ].cap[ b ] )
+			bottleneck = nodes[ j ].cap[ b ];
+	}
+	if ( bottleneck > nodes[ i ].tr_cap )
+		bottleneck = nodes[ i ].tr_cap;
+
+	for ( i=t; ; i=j ) {
+		a = nodes[ i ].parent;
+		if ( a == PARENT_TERMINAL )
+			break;
+		if ( bottleneck > nodes[ i ].cap[ a ] )
+			bottleneck = nodes[ i ].cap[ a ];
+		j = head( i, a );
+	}
+	if ( bottleneck > -nodes[ i ].tr_cap )
+		bottleneck = -nodes[ i ].tr_cap;
+
+	/* augmenting */
+	nodes[ head( s, d ) ].cap[ sister( s, d ) ] += bottleneck;
+	nodes[ s ].cap[ d ] -= bottleneck;
+
+	for ( i=s; ; i=j ) {
+		a = nodes[ i ].parent;
+		if ( a == PARENT_TERMINAL )
+			break;
+		j = head( i, a );
+		b = sister( i, a );
+		nodes[ i ].cap[ a ] += bottleneck;
+		nodes[ j ].cap[ b ] -= bottleneck;
+		if ( !nodes[ j ].cap[ b ] ) {
+			nodes[ i ].parent = PARENT_ORPHAN;
+			orphans.push_back( i );
+		}
+	}
+	nodes[ i ].tr_cap -= bottleneck;
+	if ( !nodes[ i ].tr_cap ) {
+		nodes[ i ].parent = PARENT_ORPHAN;
+		orphans.push_back( i );
+	}
+
+	for ( i=t; ; i=j ) {
+		a = nodes[ i ].parent;
+		if ( a == PARENT_TERMINAL )
+			break;
+		j = head( i, a );
+		b = sister( i, a );
+		nodes[ j ].cap[ b ] += bottleneck;
+		nodes[ i ].cap[ a ] -= bottleneck;
+		if ( !nodes[ i ].cap[ a ] ) {
+			nodes[ i ].parent = PARENT_ORPHAN;
+			orphans.push_back( i );
+		}
+	}
+	nodes[ i ].tr_cap += bottleneck;
+	if ( !nodes[ i ].tr_cap ) {
+		nodes[ i ].parent = PARENT_ORPHAN;
+		orphans.push_back( i );
+	}
+
+	flow += bottleneck;
+}
+
+
+void GridGraph::process_source_orphan( int i ) {
+	/*
+	Find a new parent for orphan i in the source tree, the
+	closest to the terminal, or free it and its children.
+	*/
+	int d, d_min = PARENT_NONE, j, a, k;
+	int dist_min = INFINITE_D, dd;
+
+	for ( d=0; d < arcs( i ); d++ ) {
+
+		j = head( i, d );
+		if ( !nodes[ j ].cap[ sister( i, d ) ] || nodes[ j ].is_sink || nodes[ j ].parent == PARENT_NONE )
+			continue;
+
+		/* checking the origin of j */
+		dd = 0;
+		for ( k=j; ; ) {
+			if ( nodes[ k ].ts == time ) {
+				dd += nodes[ k ].dist;
+				break;
+			}
+			a = nodes[ k ].parent;
+			dd++;
+			if ( a == PARENT_TERMINAL ) {
+				nodes[ k ].ts = time;
+				nodes[ k ].dist = 1;
+				break;
+			}
+			if ( a == PARENT_ORPHAN ) {
+				dd = INFINITE_D;
+				break;
+			}
+			k = head( k, a );
+		}
+
+		if ( dd < INFINITE_D ) {
+			if ( dd < dist_min ) {
+				d_min = d;
+				dist_min = dd;
+			}
+			/* set marks along the path */
+			for ( k=j; nodes[ k ].ts != time; k=head( k, nodes[ k ].parent ) ) {
+				nodes[ k ].ts = time;
+				nodes[ k ].dist = dd--;
+			}
+		}
+	}
+
+	if ( ( nodes[ i ].parent = d_min ) != PARENT_NONE ) {
+		nodes[ i ].ts = time;
+		nodes[ i ].dist = dist_min + 1;
+		return;
+	}
+
+	/* no parent is found */
+	for ( d=0; d < arcs( i ); d++ ) {
+
+		j = head( i, d );
+		a = nodes[ j ].parent;
+		if ( nodes[ j ].is_sink || a == PARENT_NONE )
+			continue;
+		if ( nodes[ j ].cap[ sister( i, d ) ] )
+			set_active( j );
+		if ( a != PARENT_TERMINAL && a != PARENT_ORPHAN && head( j, a ) == i ) {
+			nodes[ j ].parent = PARENT_ORPHAN;
+			adoption.push_back( j );
+		}
+	}
+}
+
+
+void GridGraph::process_sink_orphan( int i ) {
+	/*
+	Same, in the sink tree.
+	*/
+	int d, d_min = PARENT_NONE, j, a, k;
+	int dist_min = INFINITE_D, dd;
+
+	for ( d=0; d < arcs( i ); d++ ) {
+
+		j = head( i, d );
+		if ( !nodes[ i ].cap[ d ] || !nodes[ j ].is_sink || nodes[ j ].parent == PARENT_NONE )
+			continue;
+
+		dd = 0;
+		for ( k=j; ; ) {
+			if ( nodes[ k ].ts == time ) {
+				dd += nodes[ k ].dist;
+				break;
+			}
+			a = nodes[ k ].parent;
+			dd++;
+			if ( a == PARENT_TERMINAL ) {
+				nodes[ k ].ts = time;
+				nodes[ k ].dist = 1;
+				break;
+			}
+			if ( a == PARENT_ORPHAN ) {
+				dd = INFINITE_D;
+				break;
+			}
+			k = head( k, a );
+		}
+
+		if ( dd < INFINITE_D ) {
+			if ( dd < dist_min ) {
+				d_min = d;
+				dist_min = dd;
+			}
+			for ( k=j; nodes[ k ].ts != time; k=head( k, nodes[ k ].parent ) ) {
+				nodes[ k ].ts = time;
+				nodes[ k ].dist = dd--;
+			}
+		}
+	}
+
+	if ( ( nodes[ i ].parent = d_min ) != PARENT_NONE ) {
+		nodes[ i ].ts = time;
+		nodes[ i ].dist = dist_min + 1;
+		return;
+	}
+
+	for ( d=0; d < arcs( i ); d++ ) {
+
+		j = head( i, d );
+		a = nodes[ j ].parent;
+		if ( !nodes[ j ].is_sink || a == PARENT_NONE )
+			continue;
+		if ( nodes[ i ].cap[ d ] )
+			set_active( j );
+		if ( a != PARENT_TERMINAL && a != PARENT_ORPHAN && head( j, a ) == i ) {
+			nodes[ j ].parent = PARENT_ORPHAN;
+			adoption.push_back( j );
+		}
+	}
+}
+
+
+GridGraph::flowtype GridGraph::maxflow() {
+	/*
+	Grow the trees from the active nodes until they meet,
+	augment along the path found, adopt the orphans.
+	*/
+	int i, j, d, b, s, t, mid, current = -1;
+	size_t o;
+
+	maxflow_init();
+
+	while ( 1 ) {
+
+		if ( ( i = current ) >= 0 ) {
+			nodes[ i ].next = -1; /* remove active flag */
+			if ( nodes[ i ].parent == PARENT_NONE )
+				i = -1;
+		}
+		if ( i < 0 ) {
+			if ( ( i = next_active() ) < 0 )
+				break;
+		}
+
+		/* growth */
+		s = t = mid = -1;
+		if ( !nodes[ i ].is_sink ) {
+			/* grow source tree */
+			for ( d=0; d < arcs( i ); d++ ) {
+				if ( !nodes[ i ].cap[ d ] )
+					continue;
+				j = head( i, d );
+				b = sister( i, d );
+				if ( nodes[ j ].parent == PARENT_NONE ) {
+					nodes[ j ].is_sink = 0;
+					nodes[ j ].parent = b;
+					nodes[ j ].ts = nodes[ i ].ts;
+					nodes[ j ].dist = nodes[ i ].dist + 1;
+					set_active( j );
+				}
+				else if ( nodes[ j ].is_sink ) {
+					s = i; t = j; mid = d;
+					break;
+				}
+				else if ( nodes[ j ].ts <= nodes[ i ].ts && nodes[ j ].dist > nodes[ i ].dist ) {
+					/* heuristic - trying to make the distance from j to the source shorter */
+					nodes[ j ].parent = b;
+					nodes[ j ].ts = nodes[ i ].ts;
+					nodes[ j ].dist = nodes[ i ].dist + 1;
+				}
+			}
+		}
+		else {
+			/* grow sink tree */
+			for ( d=0; d < arcs( i ); d++ ) {
+				j = head( i, d );
+				b = sister( i, d );
+				if ( !nodes[ j ].cap[ b ] )
+					continue;
+				if ( nodes[ j ].parent == PARENT_NONE ) {
+					nodes[ j ].is_sink = 1;
+					nodes[ j ].parent = b;
+					nodes[ j ].ts = nodes[ i ].ts;
+					nodes[ j ].dist = nodes[ i ].dist + 1;
+					set_active( j );
+				}
+				else if ( !nodes[ j ].is_sink ) {
+					s = j; t = i; mid = b;
+					break;
+				}
+				else if ( nodes[ j ].ts <= nodes[ i ].ts && nodes[ j ].dist > nodes[ i ].dist ) {
+					/* heuristic - trying to make the distance from j to the sink shorter */
+					nodes[ j ].parent = b;
+					nodes[ j ].ts = nodes[ i ].ts;
+					nodes[ j ].dist = nodes[ i ].dist + 1;
+				}
+			}
+		}
+
+		time++;
+
+		if ( mid < 0 ) {
+			current = -1;
+			continue;
+		}
+
+		/* set active flag, i is processed again */
+		nodes[ i ].next = i;
+		current = i;
+
+		augment( s, t, mid );
+
+		/* adoption: the orphans of augment(), last first, each
+		   one with the orphans it makes, in order */
+		while ( !orphans.empty() ) {
+			adoption.push_back( orphans.back() );
+			orphans.pop_back();
+			for ( o=0; o < adoption.size(); o++ ) {
+				j = adoption[ o ];
+				if ( nodes[ j ].is_sink )
+					process_sink_orphan( j );
+				else
+					process_source_orphan( j );
+			}
+			adoption.clear();
+		}
+	}
+
+	return flow;
+}
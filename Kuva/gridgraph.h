@@ -0,0 +1,190 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* gridgraph.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Class GridGraph
+
+	Max flow / min cut of a patch overlap graph, with the
+	algorithm of Graph (Boykov & Kolmogorov), but with the
+	structure of the graph known: nodes are the pixels of a
+	w x h rectangle, linked to their 4 neighbours, plus the
+	seam nodes, each one between two neighbour pixels.
+
+	Nothing is allocated per node or arc: the pixels are
+	indexed over the rectangle padded by one pixel, so that
+	the neighbour of pixel p in direction d is p + offset[d],
+	and a node holds the capacities of its 4 arcs, in one
+	dense array. A seam node replaces the arcs between its
+	two pixels; these arcs are redirected through the short
+	side list of the seam nodes.
+
+	Pixels which are not added as nodes have no arcs and
+	stay out of both trees.
+
+	Same interface as Graph, but for add_node() on pixels:
+
+	GridGraph * G = new GridGraph( w, h );
+	a = G->add_node( 0, 0 );           // pixel (0,0)
+	b = G->add_node( 1, 0 );           // pixel (1,0)
+	s = G->add_node();                 // seam node
+	G->add_edge( s, a, c1, c1 );       // from the seam node, to the
+	G->add_edge( s, b, c2, c2 );       // left (top) pixel, then the other
+	G->set_tweights( s, c3, 0 );
+	flow = G->maxflow();
+	if ( G->what_segment( a ) == GridGraph::SOURCE ) ...
+*/
+
+#ifndef K_GRIDGRAPH
+#define K_GRIDGRAPH
+
+#include <vector>
+
+#include "graph.h"
+
+
+class GridGraph {
+
+public:
+
+	typedef enum { SOURCE = 0, SINK = 1 } termtype;
+
+	typedef Graph16::captype captype;
+	typedef Graph16::flowtype flowtype;
+
+	/* pixel, or (seam) node after the pixels */
+	typedef int node_id;
+
+	GridGraph( int w = 0, int h = 0 ) { reset( w, h ); }
+
+	/* a new w x h grid, keeping the memory ( see Graph::reset() ) */
+	void reset( int w, int h );
+
+	/* pixel (x,y) of the rectangle */
+	node_id add_node( int x, int y );
+
+	/* seam node */
+	node_id add_node();
+
+	/*
+	Arcs between 4-neighbour pixels, or between a seam node and
+	one of its pixels: the first edge of a seam node goes to its
+	left (top) pixel, the second one to the other pixel.
+	*/
+	void add_edge( node_id from, node_id to, captype cap, captype rev_cap );
+
+	void set_tweights( node_id i, captype cap_source, captype cap_sink );
+
+	termtype what_segment( node_id i );
+
+	flowtype maxflow();
+
+protected:
+
+	/* arc directions, d ^ 1 is the opposite one; seam nodes
+	   only have arcs 0 (to their first pixel) and 1 */
+	enum { LEFT = 0, RIGHT = 1, UP = 2, DOWN = 3 };
+
+	/* parent of a node: the direction of the arc to its
+	   parent in the tree, or one of */
+	enum { PARENT_TERMINAL = 4, PARENT_ORPHAN = 5, PARENT_NONE = 6 };
+
+	int width;  /* padded rectangle */
+	int n;      /* number of pixels, seam nodes come after */
+	int offset[ 4 ];
+
+	flowtype flow;
+
+	/* per pixel: bit d set if arc d crosses a seam node,
+	   and per direction, over the pixels: that seam node
+	   ( undefined where the bit is not set ) */
+	std::vector< unsigned char > crossed;
+	std::vector< int > via[ 4 ];
+
+	/* per seam node: its two pixels, and the direction
+	   (RIGHT or DOWN) from the first one to the second */
+	std::vector< int > ends;
+	std::vector< unsigned char > dir;
+	/* per seam node, until the second edge is added: the
+	   capacity from its first pixel */
+	std::vector< captype > pending;
+
+	/* pixels then seam nodes; all a node needs while growing
+	   the trees fits in 24 bytes, a single cache line */
+	struct node {
+		captype cap[ 4 ];       /* residual capacity of the arc in each direction */
+		captype tr_cap;         /* > 0: from SOURCE, < 0: to SINK */
+		unsigned char parent;
+		unsigned char is_sink;
+		int next;               /* active list, -1 if not in, self if last */
+		int ts;                 /* time stamp of dist */
+		int dist;               /* distance to the terminal */
+	};
+	std::vector< node > nodes;
+
+	int queue_first[ 2 ], queue_last[ 2 ];
+	std::vector< int > orphans;   /* made by augment() */
+	std::vector< int > adoption;  /* made while adopting them */
+	int time;
+
+	int arcs( int i ) { return ( i < n ) ? 4 : 2; }
+
+	/* node at the end of arc d of node i */
+	int head( int i, int d ) {
+		if ( i >= n )
+			return ends[ 2 * ( i - n ) + d ];
+		return ( crossed[ i ] & ( 1 << d ) ) ? n + via[ d ][ i ] : i + offset[ d ];
+	}
+
+	/* direction of the reverse of arc d of node i, at its head */
+	int sister( int i, int d ) {
+		if ( i >= n )
+			return dir[ i - n ] ^ d;
+		if ( !( crossed[ i ] & ( 1 << d ) ) )
+			return d ^ 1;
+		return ( d == RIGHT || d == DOWN ) ? 0 : 1;
+	}
+
+	void set_active( int i );
+	int next_active();
+
+	void maxflow_init();
+	void augment( int s, int t, int d );
+	void process_source_orphan( int i );
+	void process_sink_orphan( int i );
+};
+
+#endif
@@ -0,0 +1,285 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* holes.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Class HoleIndex
+
+	Index of the unfilled pixels of the (toroidal) texture:
+
+	- the unfilled pixels, and the frontier ones (unfilled
+	  pixels with a filled 4-neighbour), as lists with O(1)
+	  removal and random access, updated by fill();
+
+	- the connected components of the unfilled pixels, by
+	  union-find, with their bounding box and size. Filling
+	  can split a component, so they are rebuilt, in O(#unfilled),
+	  on the first query after a change; other queries do not
+	  write, and may be run from several threads.
+
+	Example usage:
+
+	HoleIndex holes;
+	holes.init( t_width, t_height );   // all unfilled
+	holes.fill( x, y );                // pixel (x,y) set
+	f = holes.frontier( rng.below( holes.frontierSize() ) );
+	c = holes.component( holes.componentOf( f ) );
+*/
+
+#ifndef K_HOLES
+#define K_HOLES
+
+#include <vector>
+
+
+class HoleIndex
+{
+public:
+
+	/* a connected set of unfilled pixels: its bounding box
+	   is the w x h rect at (x,y), wrapping around the borders */
+	struct component_t
+	{
+		unsigned x, y, w, h;
+		unsigned size;
+	};
+
+	HoleIndex() { width = height = 0; dirty = true; }
+
+	/* Set dimensions, all pixels unfilled */
+	void init( unsigned w, unsigned h )
+	{
+		unsigned i;
+
+		width = w;
+		height = h;
+		pixels.resize( w * h );
+		where.resize( w * h );
+		for ( i=0; i < w * h; i++ ) { pixels[ i ] = i; where[ i ] = i; }
+		border.clear();
+		where_border.assign( w * h, NONE );
+		parent.assign( w * h, 0 );
+		comps.clear();
+		dirty = true;
+	}
+
+	unsigned getWidth() { return width; }
+	unsigned getHeight() { return height; }
+
+	/* number of unfilled pixels */
+	unsigned size() { return (unsigned) pixels.size(); }
+	bool empty() { return pixels.empty(); }
+
+	bool filled( unsigned x, unsigned y ) { return where[ y * width + x ] == NONE; }
+
+	/* i-th unfilled pixel, as y.width + x */
+	unsigned unfilled( unsigned i ) { return pixels[ i ]; }
+
+	/* i-th frontier pixel, as y.width + x */
+	unsigned frontierSize() { return (unsigned) border.size(); }
+	unsigned frontier( unsigned i ) { return border[ i ]; }
+
+	/* Mark pixel (x,y) filled */
+	void fill( unsigned x, unsigned y )
+	{
+		unsigned p = y * width + x;
+		unsigned n[4];
+		int i;
+
+		if ( where[ p ] == NONE )
+			return;
+		remove( pixels, where, p );
+		if ( where_border[ p ] != NONE )
+			remove( border, where_border, p );
+
+		/* unfilled neighbours are now on the frontier */
+		neighbours( p, n );
+		for ( i=0; i < 4; i++ ) {
+			if ( ( where[ n[ i ] ] != NONE ) && ( where_border[ n[ i ] ] == NONE ) ) {
+				where_border[ n[ i ] ] = (unsigned) border.size();
+				border.push_back( n[ i ] );
+			}
+		}
+		dirty = true;
+	}
+
+	/* Connected components of the unfilled pixels */
+	unsigned components() { update(); return (unsigned) comps.size(); }
+
+	const component_t & component( unsigned i ) { update(); return comps[ i ]; }
+
+	/* index of the component of unfilled pixel p (y.width + x) */
+	unsigned componentOf( unsigned p ) { update(); return label[ find( p ) ]; }
+
+/***********************************************************************/
+
+private:
+
+	enum { NONE = 0xffffffff }; /* not in a list */
+
+	unsigned width, height;
+
+	std::vector< unsigned > pixels; /* unfilled pixels */
+	std::vector< unsigned > where; /* position in pixels, NONE if filled */
+	std::vector< unsigned > border; /* frontier pixels */
+	std::vector< unsigned > where_border; /* position in border, NONE if not */
+
+	/* union-find forest on the unfilled pixels, and the
+	   component index of every root */
+	std::vector< unsigned > parent;
+	std::vector< unsigned > label;
+	std::vector< component_t > comps;
+	bool dirty; /* components to rebuild */
+
+	/* Remove p from list l, by moving the last element in its place */
+	static void remove( std::vector< unsigned > & l, std::vector< unsigned > & pos, unsigned p )
+	{
+		unsigned last = l.back();
+		l[ pos[ p ] ] = last;
+		pos[ last ] = pos[ p ];
+		l.pop_back();
+		pos[ p ] = NONE;
+	}
+
+	/* 4-neighbours of p, on the torus */
+	void neighbours( unsigned p, unsigned * n )
+	{
+		unsigned x = p % width, y = p / width;
+		n[0] = y * width + ( x + width - 1 ) % width;
+		n[1] = y * width + ( x + 1 ) % width;
+		n[2] = ( ( y + height - 1 ) % height ) * width + x;
+		n[3] = ( ( y + 1 ) % height ) * width + x;
+	}
+
+	unsigned find( unsigned p )
+	{
+		unsigned r = p, q;
+		while ( parent[ r ] != r ) r = parent[ r ];
+		/* path compression */
+		while ( parent[ p ] != r ) { q = parent[ p ]; parent[ p ] = r; p = q; }
+		return r;
+	}
+
+	/* Smallest extent [lo, lo+len) of a set of coordinates on a
+	   circle of size n, from their min and max, and the min and
+	   max of the coordinates shifted by n/2 */
+	static void extent( unsigned lo, unsigned hi, unsigned slo, unsigned shi,
+		unsigned n, unsigned & start, unsigned & len )
+	{
+		start = lo;
+		len = hi - lo + 1;
+		if ( shi - slo + 1 < len ) {
+			start = ( slo + n - n / 2 ) % n;
+			len = shi - slo + 1;
+		}
+	}
+
+	/* Rebuild the components, in O(#unfilled) */
+	void update()
+	{
+		unsigned i, p, r, a, b, k, n[4];
+		/* per component: min and max of x, shifted x, y, shifted y */
+		std::vector< unsigned > box;
+
+		if ( !dirty )
+			return;
+
+		for ( i=0; i < pixels.size(); i++ )
+			parent[ pixels[ i ] ] = pixels[ i ];
+
+		/* union with the right and bottom unfilled neighbours */
+		for ( i=0; i < pixels.size(); i++ ) {
+			p = pixels[ i ];
+			neighbours( p, n );
+			for ( k=1; k < 4; k += 2 ) {
+				if ( where[ n[ k ] ] == NONE )
+					continue;
+				a = find( p );
+				b = find( n[ k ] );
+				if ( a != b ) parent[ a < b ? b : a ] = ( a < b ) ? a : b;
+			}
+		}
+
+		/* one component per root */
+		label.resize( width * height );
+		for ( i=0; i < pixels.size(); i++ )
+			label[ pixels[ i ] ] = NONE;
+		comps.clear();
+		box.clear();
+
+		for ( i=0; i < pixels.size(); i++ ) {
+
+			unsigned c[4], * m;
+
+			p = pixels[ i ];
+			r = find( p );
+			if ( label[ r ] == NONE ) {
+				component_t e = { 0, 0, 0, 0, 0 };
+				label[ r ] = (unsigned) comps.size();
+				comps.push_back( e );
+				for ( k=0; k < 4; k++ ) {
+					box.push_back( NONE );
+					box.push_back( 0 );
+				}
+			}
+
+			/* x, shifted x, y, shifted y */
+			c[0] = p % width;
+			c[1] = ( c[0] + width / 2 ) % width;
+			c[2] = p / width;
+			c[3] = ( c[2] + height / 2 ) % height;
+
+			/* flat forest: later finds do not write */
+			parent[ p ] = r;
+
+			m = &box[ 8 * label[ r ] ];
+			for ( k=0; k < 4; k++ ) {
+				if ( c[ k ] < m[ 2 * k ] ) m[ 2 * k ] = c[ k ];
+				if ( c[ k ] > m[ 2 * k + 1 ] ) m[ 2 * k + 1 ] = c[ k ];
+			}
+			comps[ label[ r ] ].size++;
+		}
+
+		for ( i=0; i < comps.size(); i++ ) {
+			unsigned * m = &box[ 8 * i ];
+			extent( m[0], m[1], m[2], m[3], width, comps[ i ].x, comps[ i ].w );
+			extent( m[4], m[5], m[6], m[7], height, comps[ i ].y, comps[ i ].h );
+		}
+		dirty = false;
+	}
+};
+
+#endif
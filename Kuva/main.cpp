@@ -67,6 +67,9 @@ int init( Args * args, vector<string> vargs ) {
 
 	if ( args->verbose() ) {
 		cout << ":: Verbose mode" << endl;
+		cout << ":: SSD kernel: " << args->ssdKernel() << endl;
+		cout << ":: Threads: " << args->nbJobs() << endl;
+		cout << ":: Batch: " << args->batchSize() << endl;
 	}
 
 	return 0;
@@ -82,7 +85,7 @@ int mkTexture( Args * args ) {
 	/*
 	Build texture and display it.
 	*/
-	vector< uint_t > vec;
+	Args::place_t vec;
 
 	/* number of pixels set */
 	uint_t same_nb=0;
@@ -94,8 +97,6 @@ int mkTexture( Args * args ) {
 	/* init first patch position */
 	vec = args->placeInit();
 
-	Graph * G;
-
 	cout << "Press Ctrl-C to interrupt and show texture" << endl;
 
 	/* Display output image */
@@ -104,8 +105,6 @@ int mkTexture( Args * args ) {
 
 	while ( !stopped  ) {
 
-		G = new Graph;
-
 		/* If stopping was pressed, wait until restart */
 
 		if ( args->getDispButton() != 0 ) {      
@@ -122,16 +121,10 @@ int mkTexture( Args * args ) {
 
 		/* Display status */
 		args->status();
-		/* Place patch */
-		vec = args->place();
-
-		/* Initialize nodes, edges, etc. */
-		args->graphCreate( G, vec );
 
-		/* Computes maxflow */
-		args->graphMaxFlow( G );
-		/* Copy the cut pixels */
-		args->graphCutSeam( G, vec );
+		/* Place patch(es), build the graphs, compute maxflow
+		and copy the cut pixels */
+		args->graphBatch( args->placeBatch() );
 
 		/* We'll use Random placing if at some time no more pixel is filled */
 		/* If still no pixel added, increment counter*/
@@ -149,7 +142,9 @@ int mkTexture( Args * args ) {
 					args->setPlacement( P2 );
 					cout << "Switch to entire patch matching." << endl;
 				}
-				else if ( args->getPlacement() == P2 ) {
+				else if ( ( args->getPlacement() == P2 ) || ( args->getPlacement() == P4 )
+					|| ( args->getPlacement() == P5 ) || ( args->getPlacement() == P6 )
+					|| ( args->getPlacement() == P7 ) ) {
 					args->setPlacement( P1 );
 					cout << "Switched to random placement." << endl;
 				}
@@ -176,11 +171,14 @@ int mkTexture( Args * args ) {
 				}
 			}
 		}
-		delete G;
 		args->refreshImageOut();
 	}
 	args->status();
 	cout << endl;
+	if ( args->verbose() ) {
+		args->ssdReport();
+		args->graphReport();
+	}
 
 	/* Display erro image */
 	args->dispImageErr("Seams");
@@ -21,12 +21,6 @@
 #include <stdio.h>
 #include "graph.h"
 
-/*
-	special constants for node->parent
-*/
-#define TERMINAL ( (arc_forward *) 1 )		/* to terminal */
-#define ORPHAN   ( (arc_forward *) 2 )		/* orphan */
-
 #define INFINITE_D 1000000000		/* infinite distance to the terminal */
 
 /***********************************************************************/
@@ -35,7 +29,7 @@
 	Functions for processing active list.
 	i->next points to the next node in the list
 	(or to i, if i is the last node in the list).
-	If i->next is NULL iff i is not in the list.
+	If i->next is -1 iff i is not in the list.
 
 	There are two queues. Active nodes are added
 	to the end of the second queue and read from
@@ -44,236 +38,274 @@
 	(and the second queue becomes empty).
 */
 
-inline void Graph::set_active(node *i)
+template < class cap_t, class flow_t >
+inline void Graph< cap_t, flow_t >::set_active(int i)
 {
-	if (!i->next)
+	if (nodes[i].next < 0)
 	{
 		/* it's not in the list yet */
-		if (queue_last[1]) queue_last[1] -> next = i;
-		else               queue_first[1]        = i;
+		if (queue_last[1] >= 0) nodes[queue_last[1]].next = i;
+		else                    queue_first[1]            = i;
 		queue_last[1] = i;
-		i -> next = i;
+		nodes[i].next = i;
 	}
 }
 
 /*
-	Returns the next active node.
+	Returns the next active node, or -1.
 	If it is connected to the sink, it stays in the list,
 	otherwise it is removed from the list
 */
-inline Graph::node * Graph::next_active()
+template < class cap_t, class flow_t >
+inline int Graph< cap_t, flow_t >::next_active()
 {
-	node *i;
+	int i;
 
 	while ( 1 )
 	{
-		if (!(i=queue_first[0]))
+		if ((i=queue_first[0]) < 0)
 		{
 			queue_first[0] = i = queue_first[1];
 			queue_last[0]  = queue_last[1];
-			queue_first[1] = NULL;
-			queue_last[1]  = NULL;
-			if (!i) return NULL;
+			queue_first[1] = -1;
+			queue_last[1]  = -1;
+			if (i < 0) return -1;
 		}
 
 		/* remove it from the active list */
-		if (i->next == i) queue_first[0] = queue_last[0] = NULL;
-		else              queue_first[0] = i -> next;
-		i -> next = NULL;
+		if (nodes[i].next == i) queue_first[0] = queue_last[0] = -1;
+		else                    queue_first[0] = nodes[i].next;
+		nodes[i].next = -1;
 
 		/* a node in the list is active iff it has a parent */
-		if (i->parent) return i;
+		if (nodes[i].parent != PARENT_NONE) return i;
 	}
 }
 
 /***********************************************************************/
 
-void Graph::maxflow_init()
+template < class cap_t, class flow_t >
+void Graph< cap_t, flow_t >::maxflow_init()
 {
-	node *i;
-	node_block *nb;
+	int i, n = (int) nodes.size();
 
-	queue_first[0] = queue_last[0] = NULL;
-	queue_first[1] = queue_last[1] = NULL;
-	orphan_first = NULL;
+	queue_first[0] = queue_last[0] = -1;
+	queue_first[1] = queue_last[1] = -1;
+	orphans.clear();
+	adoption.clear();
+	marked.clear();
 
-	for (nb=node_block_first; nb; nb=nb->next)
-	for (i=&nb->nodes[0]; i<nb->current; i++)
+	for (i=0; i<n; i++)
 	{
-		i -> next = NULL;
-		i -> TS = 0;
-		if (i->tr_cap > 0)
+		nodes[i].next = -1;
+		nodes[i].TS = 0;
+		nodes[i].is_marked = 0;
+		if (nodes[i].tr_cap > 0)
 		{
 			/* i is connected to the source */
-			i -> is_sink = 0;
-			i -> parent = TERMINAL;
+			nodes[i].is_sink = 0;
+			nodes[i].parent = PARENT_TERMINAL;
 			set_active(i);
-			i -> TS = 0;
-			i -> DIST = 1;
+			nodes[i].DIST = 1;
 		}
-		else if (i->tr_cap < 0)
+		else if (nodes[i].tr_cap < 0)
 		{
 			/* i is connected to the sink */
-			i -> is_sink = 1;
-			i -> parent = TERMINAL;
+			nodes[i].is_sink = 1;
+			nodes[i].parent = PARENT_TERMINAL;
 			set_active(i);
-			i -> TS = 0;
-			i -> DIST = 1;
+			nodes[i].DIST = 1;
 		}
 		else
 		{
-			i -> parent = NULL;
+			nodes[i].parent = PARENT_NONE;
 		}
 	}
 	TIME = 0;
 }
 
-/***********************************************************************/
-
-void Graph::augment(node *s_start, node *t_start, captype *cap_middle, captype *rev_cap_middle)
+/*
+	The trees of the previous maxflow() are valid but at the marked
+	nodes: their terminal link or their arcs have changed. A marked
+	node linked to a terminal becomes a child of it, which may move
+	it to the other tree ( its children there become orphans ),
+	otherwise it becomes an orphan; then all of them are active,
+	so that their arcs are looked at again.
+	( after the maxflow_reuse_trees_init() of Kolmogorov's maxflow 3 )
+*/
+template < class cap_t, class flow_t >
+void Graph< cap_t, flow_t >::maxflow_reuse_trees_init()
 {
-	node *i;
-	arc_forward *a;
-	captype bottleneck;
-	nodeptr *np;
+	int i, j, k, a, n = (int) nodes.size(), m = (int) head.size();
+	size_t o;
 
+	queue_first[0] = queue_last[0] = -1;
+	queue_first[1] = queue_last[1] = -1;
+	orphans.clear();
+	adoption.clear();
 
-	/* 1. Finding bottleneck capacity */
-	/* 1a - the source tree */
-	bottleneck = *cap_middle;
-	for (i=s_start; ; )
+	TIME ++;
+
+	/* nodes and edges added since */
+	for (i=n_done; i<n; i++) mark_node(i);
+	for (a=m_done; a<m; a++) mark_node(head[a]);
+
+	for (o=0; o<marked.size(); o++)
 	{
-		a = i -> parent;
-		if (a == TERMINAL) break;
-		if (IS_ODD(a))
+		i = marked[o];
+		nodes[i].is_marked = 0;
+		set_active(i);
+
+		if (nodes[i].tr_cap == 0)
 		{
-			a = MAKE_EVEN(a);
-			if (bottleneck > a->r_cap) bottleneck = a -> r_cap;
-			i = NEIGHBOR_NODE_REV(i, a -> shift);
+			if (nodes[i].parent != PARENT_NONE && nodes[i].parent != PARENT_ORPHAN)
+			{
+				/* add i to the adoption list */
+				nodes[i].parent = PARENT_ORPHAN;
+				adoption.push_back(i);
+			}
+			continue;
+		}
+
+		if (nodes[i].tr_cap > 0)
+		{
+			if (nodes[i].parent == PARENT_NONE || nodes[i].is_sink)
+			{
+				/* i goes to the source tree */
+				nodes[i].is_sink = 0;
+				for (k=first[i]; k<first[i+1]; k++)
+				{
+					a = arcs[k];
+					j = head[a];
+					if (nodes[j].is_marked) continue;
+					if (nodes[j].parent == (a^1))
+					{
+						/* add j to the adoption list */
+						nodes[j].parent = PARENT_ORPHAN;
+						adoption.push_back(j);
+					}
+					if (nodes[j].parent != PARENT_NONE && nodes[j].is_sink && r_cap[a]) set_active(j);
+				}
+			}
 		}
 		else
 		{
-			if (bottleneck > a->r_rev_cap) bottleneck = a -> r_rev_cap;
-			i = NEIGHBOR_NODE(i, a -> shift);
+			if (nodes[i].parent == PARENT_NONE || !nodes[i].is_sink)
+			{
+				/* i goes to the sink tree */
+				nodes[i].is_sink = 1;
+				for (k=first[i]; k<first[i+1]; k++)
+				{
+					a = arcs[k];
+					j = head[a];
+					if (nodes[j].is_marked) continue;
+					if (nodes[j].parent == (a^1))
+					{
+						/* add j to the adoption list */
+						nodes[j].parent = PARENT_ORPHAN;
+						adoption.push_back(j);
+					}
+					if (nodes[j].parent != PARENT_NONE && !nodes[j].is_sink && r_cap[a^1]) set_active(j);
+				}
+			}
 		}
+		nodes[i].parent = PARENT_TERMINAL;
+		nodes[i].TS = TIME;
+		nodes[i].DIST = 1;
+	}
+	marked.clear();
+
+	/* adoption */
+	for (o=0; o<adoption.size(); o++)
+	{
+		j = adoption[o];
+		if (nodes[j].is_sink) process_sink_orphan(j);
+		else                  process_source_orphan(j);
+	}
+	adoption.clear();
+	/* adoption end */
+}
+
+/***********************************************************************/
+
+/*
+	Pushes the bottleneck along SOURCE -> s_start -> t_start -> SINK,
+	a_middle being the arc s_start -> t_start.
+	In the source tree, the flow goes from the parent of a node
+	to the node ( arc parent^1 ), in the sink tree from the node
+	to its parent ( arc parent ).
+*/
+template < class cap_t, class flow_t >
+void Graph< cap_t, flow_t >::augment(int s_start, int t_start, int a_middle)
+{
+	int i, a;
+	captype bottleneck;
+
+
+	/* 1. Finding bottleneck capacity */
+	/* 1a - the source tree */
+	bottleneck = r_cap[a_middle];
+	for (i=s_start; ; i=head[a])
+	{
+		a = nodes[i].parent;
+		if (a == PARENT_TERMINAL) break;
+		if (bottleneck > r_cap[a^1]) bottleneck = r_cap[a^1];
 	}
-	if (bottleneck > i->tr_cap) bottleneck = i -> tr_cap;
+	if (bottleneck > nodes[i].tr_cap) bottleneck = nodes[i].tr_cap;
 	/* 1b - the sink tree */
-	for (i=t_start; ; )
+	for (i=t_start; ; i=head[a])
 	{
-		a = i -> parent;
-		if (a == TERMINAL) break;
-		if (IS_ODD(a))
-		{
-			a = MAKE_EVEN(a);
-			if (bottleneck > a->r_rev_cap) bottleneck = a -> r_rev_cap;
-			i = NEIGHBOR_NODE_REV(i, a -> shift);
-		}
-		else
-		{
-			if (bottleneck > a->r_cap) bottleneck = a -> r_cap;
-			i = NEIGHBOR_NODE(i, a -> shift);
-		}
+		a = nodes[i].parent;
+		if (a == PARENT_TERMINAL) break;
+		if (bottleneck > r_cap[a]) bottleneck = r_cap[a];
 	}
-	if (bottleneck > - i->tr_cap) bottleneck = - i -> tr_cap;
+	if (bottleneck > - nodes[i].tr_cap) bottleneck = - nodes[i].tr_cap;
 
 
 	/* 2. Augmenting */
 	/* 2a - the source tree */
-	*rev_cap_middle += bottleneck;
-	*cap_middle -= bottleneck;
-	for (i=s_start; ; )
+	r_cap[a_middle^1] += bottleneck;
+	r_cap[a_middle] -= bottleneck;
+	for (i=s_start; ; i=head[a])
 	{
-		a = i -> parent;
-		if (a == TERMINAL) break;
-		if (IS_ODD(a))
+		a = nodes[i].parent;
+		if (a == PARENT_TERMINAL) break;
+		r_cap[a] += bottleneck;
+		r_cap[a^1] -= bottleneck;
+		if (!r_cap[a^1])
 		{
-			a = MAKE_EVEN(a);
-			a -> r_rev_cap += bottleneck;
-			a -> r_cap -= bottleneck;
-			if (!a->r_cap)
-			{
-				/* add i to the adoption list */
-				i -> parent = ORPHAN;
-				np = nodeptr_block -> New();
-				np -> ptr = i;
-				np -> next = orphan_first;
-				orphan_first = np;
-			}
-			i = NEIGHBOR_NODE_REV(i, a -> shift);
-		}
-		else
-		{
-			a -> r_cap += bottleneck;
-			a -> r_rev_cap -= bottleneck;
-			if (!a->r_rev_cap)
-			{
-				/* add i to the adoption list */
-				i -> parent = ORPHAN;
-				np = nodeptr_block -> New();
-				np -> ptr = i;
-				np -> next = orphan_first;
-				orphan_first = np;
-			}
-			i = NEIGHBOR_NODE(i, a -> shift);
+			/* add i to the adoption list */
+			nodes[i].parent = PARENT_ORPHAN;
+			orphans.push_back(i);
 		}
 	}
-	i -> tr_cap -= bottleneck;
-	if (!i->tr_cap)
+	nodes[i].tr_cap -= bottleneck;
+	if (!nodes[i].tr_cap)
 	{
 		/* add i to the adoption list */
-		i -> parent = ORPHAN;
-		np = nodeptr_block -> New();
-		np -> ptr = i;
-		np -> next = orphan_first;
-		orphan_first = np;
+		nodes[i].parent = PARENT_ORPHAN;
+		orphans.push_back(i);
 	}
 	/* 2b - the sink tree */
-	for (i=t_start; ; )
+	for (i=t_start; ; i=head[a])
 	{
-		a = i -> parent;
-		if (a == TERMINAL) break;
-		if (IS_ODD(a))
+		a = nodes[i].parent;
+		if (a == PARENT_TERMINAL) break;
+		r_cap[a^1] += bottleneck;
+		r_cap[a] -= bottleneck;
+		if (!r_cap[a])
 		{
-			a = MAKE_EVEN(a);
-			a -> r_cap += bottleneck;
-			a -> r_rev_cap -= bottleneck;
-			if (!a->r_rev_cap)
-			{
-				/* add i to the adoption list */
-				i -> parent = ORPHAN;
-				np = nodeptr_block -> New();
-				np -> ptr = i;
-				np -> next = orphan_first;
-				orphan_first = np;
-			}
-			i = NEIGHBOR_NODE_REV(i, a -> shift);
-		}
-		else
-		{
-			a -> r_rev_cap += bottleneck;
-			a -> r_cap -= bottleneck;
-			if (!a->r_cap)
-			{
-				/* add i to the adoption list */
-				i -> parent = ORPHAN;
-				np = nodeptr_block -> New();
-				np -> ptr = i;
-				np -> next = orphan_first;
-				orphan_first = np;
-			}
-			i = NEIGHBOR_NODE(i, a -> shift);
+			/* add i to the adoption list */
+			nodes[i].parent = PARENT_ORPHAN;
+			orphans.push_back(i);
 		}
 	}
-	i -> tr_cap += bottleneck;
-	if (!i->tr_cap)
+	nodes[i].tr_cap += bottleneck;
+	if (!nodes[i].tr_cap)
 	{
 		/* add i to the adoption list */
-		i -> parent = ORPHAN;
-		np = nodeptr_block -> New();
-		np -> ptr = i;
-		np -> next = orphan_first;
-		orphan_first = np;
+		nodes[i].parent = PARENT_ORPHAN;
+		orphans.push_back(i);
 	}
 
 
@@ -282,366 +314,164 @@ void Graph::augment(node *s_start, node *t_start, captype *cap_middle, captype *
 
 /***********************************************************************/
 
-void Graph::process_source_orphan(node *i)
+template < class cap_t, class flow_t >
+void Graph< cap_t, flow_t >::process_source_orphan(int i)
 {
-	node *j;
-	arc_forward *a0_for, *a0_for_first, *a0_for_last;
-	arc_reverse *a0_rev, *a0_rev_first, *a0_rev_last;
-	arc_forward *a0_min = NULL, *a;
-	nodeptr *np;
+	int j, k, a, a0, a0_min = PARENT_NONE;
 	int d, d_min = INFINITE_D;
 
 	/* trying to find a new parent */
-	a0_for_first = i -> first_out;
-	if (IS_ODD(a0_for_first))
+	for (k=first[i]; k<first[i+1]; k++)
 	{
-		a0_for_first = (arc_forward *) (((char *)a0_for_first) + 1);
-		a0_for_last = (arc_forward *) ((a0_for_first ++) -> shift);
-	}
-	else a0_for_last = (i + 1) -> first_out;
-	a0_rev_first = i -> first_in;
-	if (IS_ODD(a0_rev_first))
-	{
-		a0_rev_first = (arc_reverse *) (((char *)a0_rev_first) + 1);
-		a0_rev_last  = (arc_reverse *) ((a0_rev_first ++) -> sister);
-	}
-	else a0_rev_last = (i + 1) -> first_in;
+		a0 = arcs[k];
+		if (!r_cap[a0^1]) continue;
 
-
-	for (a0_for=a0_for_first; a0_for<a0_for_last; a0_for++)
-	if (a0_for->r_rev_cap)
-	{
-		j = NEIGHBOR_NODE(i, a0_for -> shift);
-		if (!j->is_sink && (a=j->parent))
+		j = head[a0];
+		if (!nodes[j].is_sink && nodes[j].parent != PARENT_NONE)
 		{
 			/* checking the origin of j */
 			d = 0;
 			while ( 1 )
 			{
-				if (j->TS == TIME)
+				if (nodes[j].TS == TIME)
 				{
-					d += j -> DIST;
+					d += nodes[j].DIST;
 					break;
 				}
-				a = j -> parent;
+				a = nodes[j].parent;
 				d ++;
-				if (a==TERMINAL)
+				if (a==PARENT_TERMINAL)
 				{
-					j -> TS = TIME;
-					j -> DIST = 1;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = 1;
 					break;
 				}
-				if (a==ORPHAN) { d = INFINITE_D; break; }
-				if (IS_ODD(a))
-					j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-				else
-					j = NEIGHBOR_NODE(j, a -> shift);
+				if (a==PARENT_ORPHAN) { d = INFINITE_D; break; }
+				j = head[a];
 			}
 			if (d<INFINITE_D) /* j originates from the source - done */
 			{
 				if (d<d_min)
 				{
-					a0_min = a0_for;
+					a0_min = a0;
 					d_min = d;
 				}
 				/* set marks along the path */
-				for (j=NEIGHBOR_NODE(i, a0_for->shift); j->TS!=TIME; )
-				{
-					j -> TS = TIME;
-					j -> DIST = d --;
-					a = j->parent;
-					if (IS_ODD(a))
-						j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-					else
-						j = NEIGHBOR_NODE(j, a -> shift);
-				}
-			}
-		}
-	}
-	for (a0_rev=a0_rev_first; a0_rev<a0_rev_last; a0_rev++)
-	{
-		a0_for = a0_rev -> sister;
-		if (a0_for->r_cap)
-		{
-			j = NEIGHBOR_NODE_REV(i, a0_for -> shift);
-			if (!j->is_sink && (a=j->parent))
-			{
-				/* checking the origin of j */
-				d = 0;
-				while ( 1 )
-				{
-					if (j->TS == TIME)
-					{
-						d += j -> DIST;
-						break;
-					}
-					a = j -> parent;
-					d ++;
-					if (a==TERMINAL)
-					{
-						j -> TS = TIME;
-						j -> DIST = 1;
-						break;
-					}
-					if (a==ORPHAN) { d = INFINITE_D; break; }
-					if (IS_ODD(a))
-						j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-					else
-						j = NEIGHBOR_NODE(j, a -> shift);
-				}
-				if (d<INFINITE_D) /* j originates from the source - done */
+				for (j=head[a0]; nodes[j].TS!=TIME; j=head[nodes[j].parent])
 				{
-					if (d<d_min)
-					{
-						a0_min = MAKE_ODD(a0_for);
-						d_min = d;
-					}
-					/* set marks along the path */
-					for (j=NEIGHBOR_NODE_REV(i,a0_for->shift); j->TS!=TIME; )
-					{
-						j -> TS = TIME;
-						j -> DIST = d --;
-						a = j->parent;
-						if (IS_ODD(a))
-							j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-						else
-							j = NEIGHBOR_NODE(j, a -> shift);
-					}
+					nodes[j].TS = TIME;
+					nodes[j].DIST = d --;
 				}
 			}
 		}
 	}
 
-	if (i->parent = a0_min)
+	if ((nodes[i].parent = a0_min) != PARENT_NONE)
 	{
-		i -> TS = TIME;
-		i -> DIST = d_min + 1;
+		nodes[i].TS = TIME;
+		nodes[i].DIST = d_min + 1;
 	}
 	else
 	{
 		/* no parent is found */
-		i -> TS = 0;
+		nodes[i].TS = 0;
 
 		/* process neighbors */
-		for (a0_for=a0_for_first; a0_for<a0_for_last; a0_for++)
+		for (k=first[i]; k<first[i+1]; k++)
 		{
-			j = NEIGHBOR_NODE(i, a0_for -> shift);
-			if (!j->is_sink && (a=j->parent))
+			a0 = arcs[k];
+			j = head[a0];
+			a = nodes[j].parent;
+			if (!nodes[j].is_sink && a != PARENT_NONE)
 			{
-				if (a0_for->r_rev_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && IS_ODD(a) && NEIGHBOR_NODE_REV(j, MAKE_EVEN(a)->shift)==i)
+				if (r_cap[a0^1]) set_active(j);
+				if (a!=PARENT_TERMINAL && a!=PARENT_ORPHAN && head[a]==i)
 				{
 					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
-				}
-			}
-		}
-		for (a0_rev=a0_rev_first; a0_rev<a0_rev_last; a0_rev++)
-		{
-			a0_for = a0_rev -> sister;
-			j = NEIGHBOR_NODE_REV(i, a0_for -> shift);
-			if (!j->is_sink && (a=j->parent))
-			{
-				if (a0_for->r_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && !IS_ODD(a) && NEIGHBOR_NODE(j, a->shift)==i)
-				{
-					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
+					nodes[j].parent = PARENT_ORPHAN;
+					adoption.push_back(j);
 				}
 			}
 		}
 	}
 }
 
-void Graph::process_sink_orphan(node *i)
+template < class cap_t, class flow_t >
+void Graph< cap_t, flow_t >::process_sink_orphan(int i)
 {
-	node *j;
-	arc_forward *a0_for, *a0_for_first, *a0_for_last;
-	arc_reverse *a0_rev, *a0_rev_first, *a0_rev_last;
-	arc_forward *a0_min = NULL, *a;
-	nodeptr *np;
+	int j, k, a, a0, a0_min = PARENT_NONE;
 	int d, d_min = INFINITE_D;
 
 	/* trying to find a new parent */
-	a0_for_first = i -> first_out;
-	if (IS_ODD(a0_for_first))
+	for (k=first[i]; k<first[i+1]; k++)
 	{
-		a0_for_first = (arc_forward *) (((char *)a0_for_first) + 1);
-		a0_for_last = (arc_forward *) ((a0_for_first ++) -> shift);
-	}
-	else a0_for_last = (i + 1) -> first_out;
-	a0_rev_first = i -> first_in;
-	if (IS_ODD(a0_rev_first))
-	{
-		a0_rev_first = (arc_reverse *) (((char *)a0_rev_first) + 1);
-		a0_rev_last  = (arc_reverse *) ((a0_rev_first ++) -> sister);
-	}
-	else a0_rev_last = (i + 1) -> first_in;
-
+		a0 = arcs[k];
+		if (!r_cap[a0]) continue;
 
-	for (a0_for=a0_for_first; a0_for<a0_for_last; a0_for++)
-	if (a0_for->r_cap)
-	{
-		j = NEIGHBOR_NODE(i, a0_for -> shift);
-		if (j->is_sink && (a=j->parent))
+		j = head[a0];
+		if (nodes[j].is_sink && nodes[j].parent != PARENT_NONE)
 		{
 			/* checking the origin of j */
 			d = 0;
 			while ( 1 )
 			{
-				if (j->TS == TIME)
+				if (nodes[j].TS == TIME)
 				{
-					d += j -> DIST;
+					d += nodes[j].DIST;
 					break;
 				}
-				a = j -> parent;
+				a = nodes[j].parent;
 				d ++;
-				if (a==TERMINAL)
+				if (a==PARENT_TERMINAL)
 				{
-					j -> TS = TIME;
-					j -> DIST = 1;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = 1;
 					break;
 				}
-				if (a==ORPHAN) { d = INFINITE_D; break; }
-				if (IS_ODD(a))
-					j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-				else
-					j = NEIGHBOR_NODE(j, a -> shift);
+				if (a==PARENT_ORPHAN) { d = INFINITE_D; break; }
+				j = head[a];
 			}
 			if (d<INFINITE_D) /* j originates from the sink - done */
 			{
 				if (d<d_min)
 				{
-					a0_min = a0_for;
+					a0_min = a0;
 					d_min = d;
 				}
 				/* set marks along the path */
-				for (j=NEIGHBOR_NODE(i, a0_for->shift); j->TS!=TIME; )
+				for (j=head[a0]; nodes[j].TS!=TIME; j=head[nodes[j].parent])
 				{
-					j -> TS = TIME;
-					j -> DIST = d --;
-					a = j->parent;
-					if (IS_ODD(a))
-						j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-					else
-						j = NEIGHBOR_NODE(j, a -> shift);
-				}
-			}
-		}
-	}
-	for (a0_rev=a0_rev_first; a0_rev<a0_rev_last; a0_rev++)
-	{
-		a0_for = a0_rev -> sister;
-		if (a0_for->r_rev_cap)
-		{
-			j = NEIGHBOR_NODE_REV(i, a0_for -> shift);
-			if (j->is_sink && (a=j->parent))
-			{
-				/* checking the origin of j */
-				d = 0;
-				while ( 1 )
-				{
-					if (j->TS == TIME)
-					{
-						d += j -> DIST;
-						break;
-					}
-					a = j -> parent;
-					d ++;
-					if (a==TERMINAL)
-					{
-						j -> TS = TIME;
-						j -> DIST = 1;
-						break;
-					}
-					if (a==ORPHAN) { d = INFINITE_D; break; }
-					if (IS_ODD(a))
-						j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-					else
-						j = NEIGHBOR_NODE(j, a -> shift);
-				}
-				if (d<INFINITE_D) /* j originates from the sink - done */
-				{
-					if (d<d_min)
-					{
-						a0_min = MAKE_ODD(a0_for);
-						d_min = d;
-					}
-					/* set marks along the path */
-					for (j=NEIGHBOR_NODE_REV(i,a0_for->shift); j->TS!=TIME; )
-					{
-						j -> TS = TIME;
-						j -> DIST = d --;
-						a = j->parent;
-						if (IS_ODD(a))
-							j = NEIGHBOR_NODE_REV(j, MAKE_EVEN(a) -> shift);
-						else
-							j = NEIGHBOR_NODE(j, a -> shift);
-					}
+					nodes[j].TS = TIME;
+					nodes[j].DIST = d --;
 				}
 			}
 		}
 	}
 
-	if (i->parent = a0_min)
+	if ((nodes[i].parent = a0_min) != PARENT_NONE)
 	{
-		i -> TS = TIME;
-		i -> DIST = d_min + 1;
+		nodes[i].TS = TIME;
+		nodes[i].DIST = d_min + 1;
 	}
 	else
 	{
 		/* no parent is found */
-		i -> TS = 0;
+		nodes[i].TS = 0;
 
 		/* process neighbors */
-		for (a0_for=a0_for_first; a0_for<a0_for_last; a0_for++)
-		{
-			j = NEIGHBOR_NODE(i, a0_for -> shift);
-			if (j->is_sink && (a=j->parent))
-			{
-				if (a0_for->r_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && IS_ODD(a) && NEIGHBOR_NODE_REV(j, MAKE_EVEN(a)->shift)==i)
-				{
-					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
-				}
-			}
-		}
-		for (a0_rev=a0_rev_first; a0_rev<a0_rev_last; a0_rev++)
+		for (k=first[i]; k<first[i+1]; k++)
 		{
-			a0_for = a0_rev -> sister;
-			j = NEIGHBOR_NODE_REV(i, a0_for -> shift);
-			if (j->is_sink && (a=j->parent))
+			a0 = arcs[k];
+			j = head[a0];
+			a = nodes[j].parent;
+			if (nodes[j].is_sink && a != PARENT_NONE)
 			{
-				if (a0_for->r_rev_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && !IS_ODD(a) && NEIGHBOR_NODE(j, a->shift)==i)
+				if (r_cap[a0]) set_active(j);
+				if (a!=PARENT_TERMINAL && a!=PARENT_ORPHAN && head[a]==i)
 				{
 					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
+					nodes[j].parent = PARENT_ORPHAN;
+					adoption.push_back(j);
 				}
 			}
 		}
@@ -650,224 +480,256 @@ void Graph::process_sink_orphan(node *i)
 
 /***********************************************************************/
 
-Graph::flowtype Graph::maxflow()
+template < class cap_t, class flow_t >
+typename Graph< cap_t, flow_t >::flowtype Graph< cap_t, flow_t >::maxflow(bool reuse_trees)
 {
-	node *i, *j, *current_node = NULL, *s_start, *t_start;
-	captype *cap_middle, *rev_cap_middle;
-	arc_forward *a_for, *a_for_first, *a_for_last;
-	arc_reverse *a_rev, *a_rev_first, *a_rev_last;
-	nodeptr *np, *np_next;
+	int i, j, k, a, current_node = -1;
+	int s_start = -1, t_start = -1, a_middle;
+	size_t o;
 
-	prepare_graph();
-	maxflow_init();
-	nodeptr_block = new DBlock<nodeptr>(NODEPTR_BLOCK_SIZE, error_function);
+	/* the arcs are listed again if the graph has grown */
+	if (!reuse_trees || n_done != (int) nodes.size() || m_done != (int) head.size())
+		prepare_graph();
+	if (reuse_trees) maxflow_reuse_trees_init();
+	else             maxflow_init();
 
 	while ( 1 )
 	{
-		if (i=current_node)
+		if ((i=current_node) >= 0)
 		{
-			i -> next = NULL; /* remove active flag */
-			if (!i->parent) i = NULL;
+			nodes[i].next = -1; /* remove active flag */
+			if (nodes[i].parent == PARENT_NONE) i = -1;
 		}
-		if (!i)
+		if (i < 0)
 		{
-			if (!(i = next_active())) break;
+			if ((i = next_active()) < 0) break;
 		}
 
 		/* growth */
-		s_start = NULL;
-
-		a_for_first = i -> first_out;
-		if (IS_ODD(a_for_first))
-		{
-			a_for_first = (arc_forward *) (((char *)a_for_first) + 1);
-			a_for_last = (arc_forward *) ((a_for_first ++) -> shift);
-		}
-		else a_for_last = (i + 1) -> first_out;
-		a_rev_first = i -> first_in;
-		if (IS_ODD(a_rev_first))
-		{
-			a_rev_first = (arc_reverse *) (((char *)a_rev_first) + 1);
-			a_rev_last = (arc_reverse *) ((a_rev_first ++) -> sister);
-		}
-		else a_rev_last = (i + 1) -> first_in;
+		a_middle = -1;
 
-		if (!i->is_sink)
+		if (!nodes[i].is_sink)
 		{
 			/* grow source tree */
-			for (a_for=a_for_first; a_for<a_for_last; a_for++)
-			if (a_for->r_cap)
+			for (k=first[i]; k<first[i+1]; k++)
 			{
-				j = NEIGHBOR_NODE(i, a_for -> shift);
-				if (!j->parent)
+				a = arcs[k];
+				if (!r_cap[a]) continue;
+
+				j = head[a];
+				if (nodes[j].parent == PARENT_NONE)
 				{
-					j -> is_sink = 0;
-					j -> parent = MAKE_ODD(a_for);
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
+					nodes[j].is_sink = 0;
+					nodes[j].parent = a^1;
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 					set_active(j);
 				}
-				else if (j->is_sink)
+				else if (nodes[j].is_sink)
 				{
 					s_start = i;
 					t_start = j;
-					cap_middle     = & ( a_for -> r_cap );
-					rev_cap_middle = & ( a_for -> r_rev_cap );
+					a_middle = a;
 					break;
 				}
-				else if (j->TS <= i->TS &&
-				         j->DIST > i->DIST)
+				else if (nodes[j].TS <= nodes[i].TS &&
+				         nodes[j].DIST > nodes[i].DIST)
 				{
 					/* heuristic - trying to make the distance from j to the source shorter */
-					j -> parent = MAKE_ODD(a_for);
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
-				}
-			}
-			if (!s_start)
-			for (a_rev=a_rev_first; a_rev<a_rev_last; a_rev++)
-			{
-				a_for = a_rev -> sister;
-				if (a_for->r_rev_cap)
-				{
-					j = NEIGHBOR_NODE_REV(i, a_for -> shift);
-					if (!j->parent)
-					{
-						j -> is_sink = 0;
-						j -> parent = a_for;
-						j -> TS = i -> TS;
-						j -> DIST = i -> DIST + 1;
-						set_active(j);
-					}
-					else if (j->is_sink)
-					{
-						s_start = i;
-						t_start = j;
-						cap_middle     = & ( a_for -> r_rev_cap );
-						rev_cap_middle = & ( a_for -> r_cap );
-						break;
-					}
-					else if (j->TS <= i->TS &&
-							 j->DIST > i->DIST)
-					{
-						/* heuristic - trying to make the distance from j to the source shorter */
-						j -> parent = a_for;
-						j -> TS = i -> TS;
-						j -> DIST = i -> DIST + 1;
-					}
+					nodes[j].parent = a^1;
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 				}
 			}
 		}
 		else
 		{
 			/* grow sink tree */
-			for (a_for=a_for_first; a_for<a_for_last; a_for++)
-			if (a_for->r_rev_cap)
+			for (k=first[i]; k<first[i+1]; k++)
 			{
-				j = NEIGHBOR_NODE(i, a_for -> shift);
-				if (!j->parent)
+				a = arcs[k];
+				if (!r_cap[a^1]) continue;
+
+				j = head[a];
+				if (nodes[j].parent == PARENT_NONE)
 				{
-					j -> is_sink = 1;
-					j -> parent = MAKE_ODD(a_for);
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
+					nodes[j].is_sink = 1;
+					nodes[j].parent = a^1;
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 					set_active(j);
 				}
-				else if (!j->is_sink)
+				else if (!nodes[j].is_sink)
 				{
 					s_start = j;
 					t_start = i;
-					cap_middle     = & ( a_for -> r_rev_cap );
-					rev_cap_middle = & ( a_for -> r_cap );
+					a_middle = a^1;
 					break;
 				}
-				else if (j->TS <= i->TS &&
-				         j->DIST > i->DIST)
+				else if (nodes[j].TS <= nodes[i].TS &&
+				         nodes[j].DIST > nodes[i].DIST)
 				{
 					/* heuristic - trying to make the distance from j to the sink shorter */
-					j -> parent = MAKE_ODD(a_for);
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
-				}
-			}
-			for (a_rev=a_rev_first; a_rev<a_rev_last; a_rev++)
-			{
-				a_for = a_rev -> sister;
-				if (a_for->r_cap)
-				{
-					j = NEIGHBOR_NODE_REV(i, a_for -> shift);
-					if (!j->parent)
-					{
-						j -> is_sink = 1;
-						j -> parent = a_for;
-						j -> TS = i -> TS;
-						j -> DIST = i -> DIST + 1;
-						set_active(j);
-					}
-					else if (!j->is_sink)
-					{
-						s_start = j;
-						t_start = i;
-						cap_middle     = & ( a_for -> r_cap );
-						rev_cap_middle = & ( a_for -> r_rev_cap );
-						break;
-					}
-					else if (j->TS <= i->TS &&
-							 j->DIST > i->DIST)
-					{
-						/* heuristic - trying to make the distance from j to the sink shorter */
-						j -> parent = a_for;
-						j -> TS = i -> TS;
-						j -> DIST = i -> DIST + 1;
-					}
+					nodes[j].parent = a^1;
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 				}
 			}
 		}
 
 		TIME ++;
 
-		if (s_start)
+		if (a_middle >= 0)
 		{
-			i -> next = i; /* set active flag */
+			nodes[i].next = i; /* set active flag */
 			current_node = i;
 
 			/* augmentation */
-			augment(s_start, t_start, cap_middle, rev_cap_middle);
+			augment(s_start, t_start, a_middle);
 			/* augmentation end */
 
-			/* adoption */
-			while (np=orphan_first)
+			/* adoption: the orphans of augment(), last first,
+			   each one with the orphans it makes, in order */
+			while (!orphans.empty())
 			{
-				np_next = np -> next;
-				np -> next = NULL;
-
-				while (np=orphan_first)
+				adoption.push_back(orphans.back());
+				orphans.pop_back();
+				for (o=0; o<adoption.size(); o++)
 				{
-					orphan_first = np -> next;
-					i = np -> ptr;
-					nodeptr_block -> Delete(np);
-					if (!orphan_first) orphan_last = NULL;
-					if (i->is_sink) process_sink_orphan(i);
-					else            process_source_orphan(i);
+					j = adoption[o];
+					if (nodes[j].is_sink) process_sink_orphan(j);
+					else                  process_source_orphan(j);
 				}
-
-				orphan_first = np_next;
+				adoption.clear();
 			}
 			/* adoption end */
 		}
-		else current_node = NULL;
+		else current_node = -1;
 	}
 
-	delete nodeptr_block;
+	n_done = (int) nodes.size();
+	m_done = (int) head.size();
 
 	return flow;
 }
 
 /***********************************************************************/
 
-Graph::termtype Graph::what_segment(node_id i)
+/*
+	Parallel maxflow: the flows and the trees of the subgraphs
+	are those of the graph without the edges between them, so
+	that maxflow(true) goes on from there, the ends of these
+	edges marked. The subgraphs are built from the residual
+	capacities, and their results written back, each on its
+	own thread: their nodes and arcs are not shared.
+*/
+template < class cap_t, class flow_t >
+typename Graph< cap_t, flow_t >::flowtype Graph< cap_t, flow_t >::maxflow_parallel(int parts)
+{
+	int n = (int) nodes.size(), p;
+
+	if (parts < 2 || n < 2 * parts) return maxflow();
+
+	prepare_graph();
+	while ((int) part_graph.size() < parts)
+		part_graph.push_back(new Graph(error_function));
+	part_arcs.resize(parts);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule( static ) num_threads( parts )
+#endif
+	for (p=0; p<parts; p++)
+	{
+		Graph *g = part_graph[p];
+		std::vector< int > & emap = part_arcs[p];
+		/* nodes lo ... hi-1 */
+		int lo = (int) ((long long) n * p / parts), hi = (int) ((long long) n * (p+1) / parts);
+		int i, j, k, a, e;
+		captype tr;
+
+		g->reset();
+		emap.clear();
+		for (i=lo; i<hi; i++)
+		{
+			g->add_node();
+			tr = nodes[i].tr_cap;
+			g->set_tweights(i - lo, (tr > 0) ? tr : 0, (tr < 0) ? -tr : 0);
+		}
+		for (i=lo; i<hi; i++)
+		for (k=first[i]; k<first[i+1]; k++)
+		{
+			a = arcs[k];
+			j = head[a];
+			if (j < lo || j >= hi || (a & 1)) continue;
+			g->add_edge(i - lo, j - lo, r_cap[a], r_cap[a^1]);
+			emap.push_back(a);
+		}
+
+		g->maxflow();
+
+		for (i=lo; i<hi; i++)
+		{
+			node & d = nodes[i];
+			const node & s = g->nodes[i - lo];
+			a = s.parent;
+			d.parent = (a < 0) ? a : (emap[a >> 1] | (a & 1));
+			d.next = -1;
+			d.TS = 0;
+			d.DIST = (a == PARENT_TERMINAL) ? 1 : 0;
+			d.tr_cap = s.tr_cap;
+			d.is_sink = s.is_sink;
+			d.is_marked = 0;
+		}
+		/* the distances of the subgraph are stale: recompute the
+		   exact ones, so that a parent is always nearer to the
+		   terminal than its children ( all at the same time 0 ) */
+		for (i=lo; i<hi; i++)
+		{
+			if (nodes[i].parent < 0 || nodes[i].DIST) continue;
+			for (k=0, j=i; nodes[j].DIST == 0; j=head[nodes[j].parent]) k ++;
+			k += nodes[j].DIST;
+			for (j=i; nodes[j].DIST == 0; j=head[nodes[j].parent]) nodes[j].DIST = k --;
+		}
+		for (e=0; e<(int) emap.size(); e++)
+		{
+			r_cap[emap[e]] = g->r_cap[2*e];
+			r_cap[emap[e] + 1] = g->r_cap[2*e+1];
+		}
+	}
+
+	/* the edges between the subgraphs are new to their trees */
+	marked.clear();
+	for (p=0; p<parts; p++)
+	{
+		int lo = (int) ((long long) n * p / parts), hi = (int) ((long long) n * (p+1) / parts);
+		int i, k, j;
+
+		flow += part_graph[p] -> flow;
+		for (i=lo; i<hi; i++)
+		for (k=first[i]; k<first[i+1]; k++)
+		{
+			j = head[arcs[k]];
+			if (j < lo || j >= hi) { mark_node(i); break; }
+		}
+	}
+
+	TIME = 0;
+	n_done = n;
+	m_done = (int) head.size();
+
+	return maxflow(true);
+}
+
+/***********************************************************************/
+
+template < class cap_t, class flow_t >
+typename Graph< cap_t, flow_t >::termtype Graph< cap_t, flow_t >::what_segment(node_id i)
 {
-	if (((node*)i)->parent && !((node*)i)->is_sink) return SOURCE;
+	if (nodes[i].parent != PARENT_NONE && !nodes[i].is_sink) return SOURCE;
 	return SINK;
 }
 
+
+/* instances ( see graph.h ) */
+template class Graph< short, unsigned >;
+template class Graph< float, double >;
@@ -0,0 +1,95 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* rng.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Class RandomStream
+
+	A small pseudo-random generator (xorshift64*, seeded with
+	splitmix64), of which many independent streams can be
+	drawn from one seed.
+
+	Placement candidates each get their own stream, so that
+	the offsets tried do not depend on the order (or the
+	thread) in which candidates are evaluated.
+
+	Example usage:
+
+	RandomStream rng( seed, i ); // i-th stream of seed
+	x = rng.below( t_width );    // x in [0, t_width)
+*/
+
+#ifndef K_RNG
+#define K_RNG
+
+
+class RandomStream
+{
+public:
+
+	RandomStream( unsigned long long seed, unsigned long long stream )
+	{
+		/* splitmix64 of ( seed, stream ), never zero */
+		unsigned long long z = seed + ( stream + 1 ) * 0x9e3779b97f4a7c15ULL;
+		z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+		z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+		state = ( z ^ ( z >> 31 ) ) | 1;
+	}
+
+	/* 32 random bits */
+	unsigned int next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (unsigned int) ( ( state * 0x2545f4914f6cdd1dULL ) >> 32 );
+	}
+
+	/* uniform in [0,1) */
+	double uniform() { return next() * ( 1.0 / 4294967296.0 ); }
+
+	/* uniform in [0,n) */
+	unsigned int below( unsigned int n )
+	{
+		return (unsigned int) ( ( (unsigned long long) next() * n ) >> 32 );
+	}
+
+private:
+
+	unsigned long long state;
+};
+
+#endif
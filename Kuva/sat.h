@@ -0,0 +1,161 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* sat.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Template class SumTable
+
+	A toroidal image of values and its summed-area table,
+	to get the sum over any (wrapping) window in O(1).
+
+	Values are changed with set(); the table is rebuilt
+	lazily on the next query, only from the first row
+	changed, so a whole texture row range is rebuilt
+	at most once per placement.
+
+	Example usage, with the occupancy mask:
+
+	SumTable< unsigned > msk;
+	msk.init( t_width, t_height );
+	msk.set( x, y, 1 );                     // pixel (x,y) filled
+	n = msk.sum( x, y, p_width, p_height ); // filled pixels under
+	                                        // a patch at (x,y)
+*/
+
+#ifndef K_SAT
+#define K_SAT
+
+#include <vector>
+
+
+template <class Type> class SumTable
+{
+public:
+
+	SumTable() { width = height = 0; dirty = 0; }
+
+	/* Set dimensions, all values to zero */
+	void init( unsigned w, unsigned h )
+	{
+		width = w;
+		height = h;
+		cells.assign( w * h, 0 );
+		table.assign( ( w + 1 ) * ( h + 1 ), 0 );
+		dirty = h;
+	}
+
+	unsigned getWidth() { return width; }
+	unsigned getHeight() { return height; }
+
+	Type get( unsigned x, unsigned y ) { return cells[ y * width + x ]; }
+
+	void set( unsigned x, unsigned y, Type v )
+	{
+		cells[ y * width + x ] = v;
+		if ( y < dirty ) dirty = y;
+	}
+
+	/* Sum over all the values */
+	Type total() { update(); return table[ height * ( width + 1 ) + width ]; }
+
+	/* Sum over the w x h window at (x,y), wrapping around the
+	   borders; requires x < width, y < height, w <= width
+	   and h <= height */
+	Type sum( unsigned x, unsigned y, unsigned w, unsigned h )
+	{
+		unsigned x1 = x + w, y1 = y + h;
+		Type s;
+
+		update();
+
+		if ( x1 <= width )
+		{
+			if ( y1 <= height ) return rect( x, y, x1, y1 );
+			return rect( x, y, x1, height ) + rect( x, 0, x1, y1 - height );
+		}
+		if ( y1 <= height )
+			return rect( x, y, width, y1 ) + rect( 0, y, x1 - width, y1 );
+
+		s  = rect( x, y, width, height );
+		s += rect( 0, y, x1 - width, height );
+		s += rect( x, 0, width, y1 - height );
+		s += rect( 0, 0, x1 - width, y1 - height );
+		return s;
+	}
+
+/***********************************************************************/
+
+private:
+
+	unsigned width, height;
+	unsigned dirty; /* first row of cells changed since last update */
+
+	std::vector< Type > cells; /* width x height values */
+	std::vector< Type > table; /* (width+1) x (height+1) prefix sums */
+
+	/* Sum over [x0,x1) x [y0,y1), no wrapping */
+	Type rect( unsigned x0, unsigned y0, unsigned x1, unsigned y1 )
+	{
+		unsigned W = width + 1;
+		return table[ y1 * W + x1 ] - table[ y0 * W + x1 ]
+			- table[ y1 * W + x0 ] + table[ y0 * W + x0 ];
+	}
+
+	/* Rebuild the prefix sums below the first changed row
+	   (nothing is written when up to date, so that queries
+	   may be run from several threads between changes) */
+	void update()
+	{
+		unsigned x, y, W = width + 1;
+		Type row;
+
+		if ( dirty >= height )
+			return;
+
+		for ( y=dirty; y < height; y++ )
+		{
+			row = 0;
+			for ( x=0; x < width; x++ )
+			{
+				row += cells[ y * width + x ];
+				table[ ( y + 1 ) * W + x + 1 ] = table[ y * W + x + 1 ] + row;
+			}
+		}
+		dirty = height;
+	}
+};
+
+#endif
@@ -0,0 +1,315 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* ssd.cpp
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "ssd.h"
+
+
+/*
+Vector kernels are built on x86 only. With gcc each one is compiled
+for its own instruction set (target attribute), so that the rest
+of the program still runs on any CPU; MSVC needs no flag to use
+intrinsics, but knows AVX2 since VS2012 and AVX-512 since VS2017.
+*/
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define K_X86
+#define K_TARGET( t ) __attribute__(( target( t ) ))
+#define K_AVX2
+#define K_AVX512
+#include <immintrin.h>
+#elif defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+#define K_X86
+#define K_TARGET( t )
+#if _MSC_VER >= 1700
+#define K_AVX2
+#endif
+#if _MSC_VER >= 1911
+#define K_AVX512
+#endif
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+ssd_row_t ssdRow = ssdRowScalar;
+
+
+/**********/
+/* SCALAR */
+/**********/
+
+
+unsigned int ssdRowScalar( const unsigned char * a, const unsigned char * b,
+						  const unsigned char * m, unsigned int n ) {
+	/*
+	Reference kernel.
+	*/
+	unsigned int i, s = 0;
+	int d;
+
+	for ( i=0; i < n; i++ ) {
+		if ( m[ i ] != 0 ) {
+			d = (int) a[ i ] - (int) b[ i ];
+			s += d * d;
+		}
+	}
+	return s;
+}
+
+
+/**********/
+/* VECTOR */
+/**********/
+
+/*
+The tails (less than a vector) go to the scalar kernel: calling
+the SSE2 one from AVX code would pay for the AVX/SSE transition.
+*/
+
+#ifdef K_X86
+
+K_TARGET( "sse2" )
+unsigned int ssdRowSSE2( const unsigned char * a, const unsigned char * b,
+						const unsigned char * m, unsigned int n ) {
+	/*
+	8 pixels per step: bytes widened to 16 bits, differences
+	zeroed where the mask is, squared and summed by pairs
+	with pmaddwd into 4 x 32 bits.
+	*/
+	unsigned int i = 0, s;
+	__m128i zero = _mm_setzero_si128();
+	__m128i acc = _mm_setzero_si128();
+
+	for ( ; i + 8 <= n; i += 8 ) {
+
+		__m128i va = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *) ( a + i ) ), zero );
+		__m128i vb = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *) ( b + i ) ), zero );
+		__m128i d = _mm_sub_epi16( va, vb );
+
+		/* 0xffff where the pixel is empty */
+		__m128i mm = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i *) ( m + i ) ), zero );
+		d = _mm_andnot_si128( _mm_cmpeq_epi16( mm, zero ), d );
+
+		acc = _mm_add_epi32( acc, _mm_madd_epi16( d, d ) );
+	}
+
+	acc = _mm_add_epi32( acc, _mm_srli_si128( acc, 8 ) );
+	acc = _mm_add_epi32( acc, _mm_srli_si128( acc, 4 ) );
+	s = (unsigned int) _mm_cvtsi128_si32( acc );
+
+	return s + ssdRowScalar( a + i, b + i, m + i, n - i );
+}
+
+#else
+
+unsigned int ssdRowSSE2( const unsigned char * a, const unsigned char * b,
+						const unsigned char * m, unsigned int n ) {
+	return ssdRowScalar( a, b, m, n );
+}
+
+#endif
+
+
+#ifdef K_AVX2
+
+K_TARGET( "avx2" )
+unsigned int ssdRowAVX2( const unsigned char * a, const unsigned char * b,
+						const unsigned char * m, unsigned int n ) {
+	/*
+	Same as SSE2, 16 pixels per step.
+	*/
+	unsigned int i = 0;
+	__m256i zero = _mm256_setzero_si256();
+	__m256i acc = _mm256_setzero_si256();
+	__m128i s;
+
+	for ( ; i + 16 <= n; i += 16 ) {
+
+		__m256i va = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *) ( a + i ) ) );
+		__m256i vb = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *) ( b + i ) ) );
+		__m256i d = _mm256_sub_epi16( va, vb );
+
+		__m256i mm = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *) ( m + i ) ) );
+		d = _mm256_andnot_si256( _mm256_cmpeq_epi16( mm, zero ), d );
+
+		acc = _mm256_add_epi32( acc, _mm256_madd_epi16( d, d ) );
+	}
+
+	s = _mm_add_epi32( _mm256_castsi256_si128( acc ), _mm256_extracti128_si256( acc, 1 ) );
+	s = _mm_add_epi32( s, _mm_srli_si128( s, 8 ) );
+	s = _mm_add_epi32( s, _mm_srli_si128( s, 4 ) );
+
+	return (unsigned int) _mm_cvtsi128_si32( s ) + ssdRowScalar( a + i, b + i, m + i, n - i );
+}
+
+#else
+
+unsigned int ssdRowAVX2( const unsigned char * a, const unsigned char * b,
+						const unsigned char * m, unsigned int n ) {
+	return ssdRowSSE2( a, b, m, n );
+}
+
+#endif
+
+
+#ifdef K_AVX512
+
+K_TARGET( "avx512f,avx512bw" )
+unsigned int ssdRowAVX512( const unsigned char * a, const unsigned char * b,
+						  const unsigned char * m, unsigned int n ) {
+	/*
+	32 pixels per step, the mask goes in a k register.
+	*/
+	unsigned int i = 0;
+	__m512i acc = _mm512_setzero_si512();
+	__m256i h;
+	__m128i s;
+
+	for ( ; i + 32 <= n; i += 32 ) {
+
+		__m512i va = _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i *) ( a + i ) ) );
+		__m512i vb = _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i *) ( b + i ) ) );
+
+		__m512i mm = _mm512_cvtepu8_epi16( _mm256_loadu_si256( (const __m256i *) ( m + i ) ) );
+		__mmask32 k = _mm512_test_epi16_mask( mm, mm );
+
+		__m512i d = _mm512_maskz_sub_epi16( k, va, vb );
+		acc = _mm512_add_epi32( acc, _mm512_madd_epi16( d, d ) );
+	}
+
+	/* by hand, with the zero masked extracts: the other 512 to 256
+	bit intrinsics ( _mm512_reduce_add_epi32(), _mm512_castsi512_si256()
+	... ) make gcc 12 warn about their undefined operand ( -Wall ) */
+	h = _mm256_add_epi32( _mm512_maskz_extracti64x4_epi64( 0xff, acc, 0 ),
+		_mm512_maskz_extracti64x4_epi64( 0xff, acc, 1 ) );
+	s = _mm_add_epi32( _mm256_castsi256_si128( h ), _mm256_extracti128_si256( h, 1 ) );
+	s = _mm_add_epi32( s, _mm_srli_si128( s, 8 ) );
+	s = _mm_add_epi32( s, _mm_srli_si128( s, 4 ) );
+
+	return (unsigned int) _mm_cvtsi128_si32( s ) + ssdRowScalar( a + i, b + i, m + i, n - i );
+}
+
+#else
+
+unsigned int ssdRowAVX512( const unsigned char * a, const unsigned char * b,
+						  const unsigned char * m, unsigned int n ) {
+	return ssdRowAVX2( a, b, m, n );
+}
+
+#endif
+
+
+/************/
+/* DISPATCH */
+/************/
+
+
+static int cpuLevel() {
+	/*
+	Best kernel the CPU (and the OS, for the AVX registers) supports.
+	*/
+#if defined(K_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+#ifdef K_AVX512
+	if ( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" ) )
+		return SSD_AVX512;
+#endif
+	if ( __builtin_cpu_supports( "avx2" ) )
+		return SSD_AVX2;
+	if ( __builtin_cpu_supports( "sse2" ) )
+		return SSD_SSE2;
+	return SSD_SCALAR;
+#elif defined(K_X86)
+	int r[4];
+	unsigned long long xcr0 = 0;
+
+	__cpuid( r, 0 );
+	if ( r[0] < 7 ) {
+		__cpuid( r, 1 );
+		return ( r[3] & ( 1 << 26 ) ) ? SSD_SSE2 : SSD_SCALAR;
+	}
+	__cpuid( r, 1 );
+	if ( !( r[3] & ( 1 << 26 ) ) )
+		return SSD_SCALAR;
+	/* OSXSAVE: registers saved by the OS */
+	if ( r[2] & ( 1 << 27 ) )
+		xcr0 = _xgetbv( 0 );
+
+	__cpuidex( r, 7, 0 );
+#ifdef K_AVX512
+	/* AVX512F, AVX512BW, and opmask/ZMM state */
+	if ( ( r[1] & ( 1 << 16 ) ) && ( r[1] & ( 1 << 30 ) ) && ( ( xcr0 & 0xe6 ) == 0xe6 ) )
+		return SSD_AVX512;
+#endif
+#ifdef K_AVX2
+	if ( ( r[1] & ( 1 << 5 ) ) && ( ( xcr0 & 0x6 ) == 0x6 ) )
+		return SSD_AVX2;
+#endif
+	return SSD_SSE2;
+#else
+	return SSD_SCALAR;
+#endif
+}
+
+
+int ssdInit( int level ) {
+	/*
+	Select the kernel.
+	*/
+	int cpu = cpuLevel();
+
+	if ( level > cpu )
+		level = cpu;
+
+	switch ( level ) {
+		case SSD_AVX512: ssdRow = ssdRowAVX512; break;
+		case SSD_AVX2: ssdRow = ssdRowAVX2; break;
+		case SSD_SSE2: ssdRow = ssdRowSSE2; break;
+		default: level = SSD_SCALAR; ssdRow = ssdRowScalar; break;
+	}
+	return level;
+}
+
+
+const char * ssdName( int kernel ) {
+
+	switch ( kernel ) {
+		case SSD_AVX512: return "AVX-512";
+		case SSD_AVX2: return "AVX2";
+		case SSD_SSE2: return "SSE2";
+		default: return "scalar";
+	}
+}
@@ -0,0 +1,87 @@
+/*******************************
+*
+* Kuva - Graph cut texturing
+*
+* From:
+*      V.Kwatra, A.Schdl, I.Essa, G.Turk, A.Bobick,
+*      Graphcut Textures: Image and Video Synthesis Using Graph Cuts
+*      http://www.cc.gatech.edu/cpl/projects/graphcuttextures/
+*
+* JP <jeanphilippe.aumasson@gmail.com>
+*
+* ssd.h
+*
+* 01/2006
+*
+*******************************/
+/*
+
+Copyright Jean-Philippe Aumasson, 2005, 2006
+
+Kuva is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+	Masked sum of squared differences over a row of pixels
+	(one channel), the inner loop of the matching placements:
+
+	  sum over i < n of ( a[i] - b[i] )^2, where m[i] != 0
+
+	The scalar version is the reference, the SSE2, AVX2 and
+	AVX-512 versions are selected at run time by ssdInit(),
+	according to the CPU features, and called through ssdRow.
+	A row must not be longer than 66051 pixels (32 bit sums).
+*/
+
+#ifndef K_SSD
+#define K_SSD
+
+/* kernels, from slowest to fastest */
+#define SSD_SCALAR 0
+#define SSD_SSE2   1
+#define SSD_AVX2   2
+#define SSD_AVX512 3
+
+typedef unsigned int ( * ssd_row_t )( const unsigned char * a, const unsigned char * b,
+	const unsigned char * m, unsigned int n );
+
+/* selected kernel */
+extern ssd_row_t ssdRow;
+
+/*
+Select the fastest kernel supported by the CPU, but not faster
+than 'level' (SSD_SCALAR ... SSD_AVX512); return the kernel
+actually selected.
+*/
+int ssdInit( int level = SSD_AVX512 );
+
+/* name of a kernel, for verbose mode */
+const char * ssdName( int kernel );
+
+unsigned int ssdRowScalar( const unsigned char * a, const unsigned char * b,
+	const unsigned char * m, unsigned int n );
+
+unsigned int ssdRowSSE2( const unsigned char * a, const unsigned char * b,
+	const unsigned char * m, unsigned int n );
+
+unsigned int ssdRowAVX2( const unsigned char * a, const unsigned char * b,
+	const unsigned char * m, unsigned int n );
+
+unsigned int ssdRowAVX512( const unsigned char * a, const unsigned char * b,
+	const unsigned char * m, unsigned int n );
+
+#endif